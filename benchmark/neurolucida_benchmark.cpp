@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_benchmark.cpp
+ * \brief times the phases of a conversion on synthetic or given morphologies
+ *
+ * Usage: neurolucida_benchmark [options]
+ *   --input FILE        convert FILE instead of a synthetic morphology
+ *   --output FILE       name of the synthetic morphology (default: synthetic_morphology.xml)
+ *   --trees N           number of trees
+ *   --depth N           number of binary branchings per tree
+ *   --points N          points per branch
+ *   --contour N         points of the soma contour
+ *   --no-soma           omit the "Cell Body" contour
+ *   --seed N            seed of the random directions
+ *   --format ugx|obj|none  output format written in the save phase (default: ugx)
+ *   --repeat N          number of conversions, the fastest run is reported
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+#include "ug.h"
+#include "lib_grid/global_attachments.h"
+#include "../neurolucida.h"
+#include "synthetic_morphology.h"
+
+using namespace ug;
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	/*!
+	 * \brief peak resident memory of the process in MiB
+	 */
+	double peak_memory_mib() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+		return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+		return usage.ru_maxrss / (1024.0 * 1024.0); /// bytes
+#else
+		return usage.ru_maxrss / 1024.0; /// kilobytes
+#endif
+#endif
+	}
+
+	typedef chrono::steady_clock Clock;
+
+	double seconds_since(const Clock::time_point& start) {
+		return chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	size_t size_argument(int argc, char** argv, int& i) {
+		if (i + 1 >= argc) {
+			cerr << "Missing value for " << argv[i] << endl;
+			exit(1);
+		}
+		return static_cast<size_t>(atol(argv[++i]));
+	}
+}
+
+int main(int argc, char** argv) {
+	SyntheticMorphologyParams params;
+	string input;
+	string synthetic = "synthetic_morphology.xml";
+	string format = "ugx";
+	size_t repeat = 1;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) input = argv[++i];
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) synthetic = argv[++i];
+		else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) format = argv[++i];
+		else if (strcmp(argv[i], "--trees") == 0) params.numTrees = size_argument(argc, argv, i);
+		else if (strcmp(argv[i], "--depth") == 0) params.branchingDepth = size_argument(argc, argv, i);
+		else if (strcmp(argv[i], "--points") == 0) params.pointsPerBranch = size_argument(argc, argv, i);
+		else if (strcmp(argv[i], "--contour") == 0) params.contourPoints = size_argument(argc, argv, i);
+		else if (strcmp(argv[i], "--seed") == 0) params.seed = static_cast<unsigned int>(size_argument(argc, argv, i));
+		else if (strcmp(argv[i], "--repeat") == 0) repeat = max<size_t>(1, size_argument(argc, argv, i));
+		else if (strcmp(argv[i], "--no-soma") == 0) params.soma = false;
+		else {
+			cerr << "Unknown option '" << argv[i] << "', see the file header of neurolucida_benchmark.cpp." << endl;
+			return 1;
+		}
+	}
+
+	UGInit(&argc, &argv);
+	if (!GlobalAttachments::is_declared("diameter")) {
+		GlobalAttachments::declare_attachment<ANumber>("diameter");
+	}
+
+	if (input.empty()) {
+		Clock::time_point start = Clock::now();
+		size_t numPoints = WriteSyntheticMorphology(synthetic, params);
+		cout << "Generated '" << synthetic << "' with " << numPoints << " points in " << seconds_since(start) << " s." << endl;
+		input = synthetic;
+	}
+
+	/// phases as measured by the converter itself, see Statistics
+	vector<double> best(Statistics::NUM_PHASES + 1, numeric_limits<double>::max());
+	size_t numVertices = 0;
+	size_t numEdges = 0;
+	for (size_t r = 0; r < repeat; r++) {
+		Neurolucida benchmark;
+		benchmark.set_log_level(Neurolucida::LOG_SILENT);
+		benchmark.convert(input, format == "ugx", format == "obj");
+
+		const Statistics& statistics = benchmark.get_statistics();
+		for (size_t i = 0; i < Statistics::NUM_PHASES; i++) {
+			best[i] = min(best[i], statistics.phase_time(static_cast<int>(i)));
+		}
+		best[Statistics::NUM_PHASES] = min(best[Statistics::NUM_PHASES], statistics.total_time());
+		numVertices = benchmark.grid().num_vertices();
+		numEdges = benchmark.grid().num_edges();
+	}
+
+	cout << "Phase timings of '" << input << "' (best of " << repeat << "):" << endl;
+	for (size_t i = 0; i < Statistics::NUM_PHASES; i++) {
+		cout << "\t" << setw(18) << left << Statistics::phase_name(static_cast<int>(i)) << right << fixed << setprecision(6) << best[i] << " s" << endl;
+	}
+	cout << "\t" << setw(18) << left << "total" << right << fixed << setprecision(6) << best[Statistics::NUM_PHASES] << " s" << endl;
+	cout << "Vertices: " << numVertices << ", edges: " << numEdges << endl;
+	cout << "Peak memory: " << setprecision(1) << peak_memory_mib() << " MiB" << endl;
+
+	UGFinalize();
+	return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file synthetic_morphology.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "synthetic_morphology.h"
+
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+namespace ug {
+	namespace neurolucida {
+		namespace {
+			const double PI = 3.14159265358979323846;
+			const double SOMA_RADIUS = 10.0;
+
+			struct Direction {
+				double x, y, z;
+			};
+
+			Direction normalized(double x, double y, double z) {
+				double length = sqrt(x*x + y*y + z*z);
+				Direction dir = {x / length, y / length, z / length};
+				return dir;
+			}
+
+			void write_point(ofstream& out, const string& indent, double x, double y, double z, double d) {
+				out << indent << "<point x=\"" << x << "\" y=\"" << y << "\" z=\"" << z << "\" d=\"" << d << "\"/>\n";
+			}
+
+			/*!
+			 * \brief writes one branch and recursively its two children
+			 * \return number of points written
+			 */
+			size_t write_branch(ofstream& out, const SyntheticMorphologyParams& params, mt19937& rng,
+								double x, double y, double z, double d, Direction dir,
+								size_t depth, const string& indent) {
+				normal_distribution<double> jitter(0.0, 0.05);
+				size_t numPoints = 0;
+				for (size_t i = 0; i < params.pointsPerBranch; i++) {
+					dir = normalized(dir.x + jitter(rng), dir.y + jitter(rng), dir.z + jitter(rng));
+					x += dir.x * params.segmentLength;
+					y += dir.y * params.segmentLength;
+					z += dir.z * params.segmentLength;
+					d = max(0.2, d * 0.995);
+					write_point(out, indent, x, y, z, d);
+					numPoints++;
+				}
+
+				if (depth == params.branchingDepth) return numPoints;
+
+				/// two children deviating from the parent direction to opposite sides
+				uniform_real_distribution<double> angle(0.3, 0.8);
+				Direction side = normalized(-dir.y + jitter(rng), dir.x + jitter(rng), dir.z * 0.5 + jitter(rng));
+				for (int child = 0; child < 2; child++) {
+					double a = (child == 0 ? 1 : -1) * angle(rng);
+					Direction childDir = normalized(dir.x + a * side.x, dir.y + a * side.y, dir.z + a * side.z);
+					out << indent << "<branch>\n";
+					numPoints += write_branch(out, params, rng, x, y, z, d * 0.8, childDir, depth + 1, indent + "  ");
+					out << indent << "</branch>\n";
+				}
+				return numPoints;
+			}
+		}
+
+		size_t WriteSyntheticMorphology(const string& filename, const SyntheticMorphologyParams& params) {
+			ofstream out(filename.c_str());
+			if (!out) throw runtime_error("Could not open '" + filename + "' for writing.");
+			out.precision(6);
+			out << fixed;
+
+			mt19937 rng(params.seed);
+			size_t numPoints = 0;
+
+			out << "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n";
+			out << "<mbf version=\"4.0\" xmlns=\"http://www.mbfbioscience.com/2007/neurolucida\" appname=\"Synthetic\" appversion=\"1.0\">\n";
+
+			if (params.soma && params.contourPoints >= 3) {
+				out << "<contour name=\"Cell Body\" color=\"#FF0000\" closed=\"true\" shape=\"Contour\">\n";
+				for (size_t i = 0; i < params.contourPoints; i++) {
+					double phi = 2 * PI * i / params.contourPoints;
+					write_point(out, "  ", SOMA_RADIUS * cos(phi), SOMA_RADIUS * sin(phi), 0.0, 0.5);
+					numPoints++;
+				}
+				out << "</contour>\n";
+			}
+
+			for (size_t t = 0; t < params.numTrees; t++) {
+				/// roots are distributed evenly on the soma outline
+				double phi = 2 * PI * (t + 0.5) / max<size_t>(params.numTrees, 1);
+				Direction dir = normalized(cos(phi), sin(phi), 0.1);
+				out << "<tree color=\"" << (t == 0 ? "#00FFFF" : "#00FF00") << "\" type=\"" << (t == 0 ? "Axon" : "Dendrite") << "\" leaf=\"Normal\">\n";
+				double x = SOMA_RADIUS * cos(phi);
+				double y = SOMA_RADIUS * sin(phi);
+				write_point(out, "  ", x, y, 0.0, 2.0);
+				numPoints++;
+				numPoints += write_branch(out, params, rng, x, y, 0.0, 2.0, dir, 0, "  ");
+				out << "</tree>\n";
+			}
+
+			out << "</mbf>\n";
+			return numPoints;
+		}
+	}
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file synthetic_morphology.h
+ * \brief writes synthetic Neurolucida XML files for benchmarking
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__SYNTHETIC_MORPHOLOGY__
+#define __H__UG__NEUROLUCIDA__SYNTHETIC_MORPHOLOGY__
+
+#include <string>
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief shape of a synthetic morphology
+		 * Every tree starts at the soma surface with one branch of pointsPerBranch
+		 * points, which is split binary up to branchingDepth times, i.e. a tree has
+		 * (2^(branchingDepth+1) - 1) * pointsPerBranch points plus its root point.
+		 */
+		struct SyntheticMorphologyParams {
+			size_t numTrees; ///<! number of trees (first one is an axon)
+			size_t branchingDepth; ///<! number of binary branchings per tree
+			size_t pointsPerBranch; ///<! points of every branch
+			size_t contourPoints; ///<! points of the soma contour
+			bool soma; ///<! write a "Cell Body" contour
+			double segmentLength; ///<! distance of consecutive points in micrometer
+			unsigned int seed; ///<! seed of the random directions
+
+			SyntheticMorphologyParams() : numTrees(8),
+										  branchingDepth(4),
+										  pointsPerBranch(32),
+										  contourPoints(64),
+										  soma(true),
+										  segmentLength(1.0),
+										  seed(1) {
+			}
+		};
+
+		/*!
+		 * \brief writes a synthetic morphology in Neurolucida XML format
+		 * \return number of points written
+		 */
+		size_t WriteSyntheticMorphology(const std::string& filename, const SyntheticMorphologyParams& params);
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__SYNTHETIC_MORPHOLOGY__
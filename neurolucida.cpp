@@ -39,8 +39,13 @@
  */
 
 #include "neurolucida.h"
+#include "neurolucida_stream_reader.h"
 
 #include <fstream>
+#include <future>
+#include <iomanip>
+#include <iterator>
+#include <limits>
 
 using namespace ug::neurolucida;
 using namespace std;
@@ -48,11 +53,92 @@ using namespace std;
 number Neurolucida::REMOVE_DOUBLE_THRESHOLD = 1e-6;
 std::string Neurolucida::OBJ_EXTENSION = ".obj";
 std::string Neurolucida::UGX_EXTENSION = ".ugx";
+std::string Neurolucida::SWC_EXTENSION = ".swc";
+std::string Neurolucida::MORPHOMETRICS_CSV_EXTENSION = ".morphometrics.csv";
+std::string Neurolucida::MORPHOMETRICS_JSON_EXTENSION = ".morphometrics.json";
+std::string Neurolucida::STATISTICS_EXTENSION = ".statistics.json";
 int Neurolucida::DEFAULT_SUBSET_COLOR = 1; /// RED
 
 void Neurolucida::parse_file(const std::string& filename) {
+    m_statistics.clear();
+    {
+        Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OTHER);
+        parse_document(filename);
+    }
+
+    if (m_bStatisticsOutput) write_statistics();
+}
+
+void Neurolucida::write_statistics() {
+    std::string filename = output_file_name(STATISTICS_EXTENSION);
+    OutputFile out;
+    UG_COND_THROW(!out.open(filename, m_compression), "Could not open file '" << filename << "'.");
+    m_statistics.write_json(out);
+    UG_COND_THROW(!out.close(), "Could not write file '" << filename << "'.");
+    NEUROLUCIDA_LOGN(LOG_SUMMARY, "written statistics file '" << filename << "'");
+}
+
+void Neurolucida::parse_document(const std::string& filename) {
+    int compression = CompressionOfFile(filename);
+    UG_COND_THROW(!CompressionAvailable(compression), "Compression of file '" << filename << "' is not available in this build.");
+
+    /// a previous conversion by this instance is replaced
+    clear_document();
+
+    if (m_bStreaming) {
+        m_statistics.set(Statistics::COUNTER_BYTES_READ, FileSize(filename));
+        parse_file_streaming(filename);
+        return;
+    }
+
+    /// a cached document is created without parsing the file
+    m_cacheKey = CacheKey();
+    bool cached = false;
+    if (!m_cacheDirectory.empty()) {
+        Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_READ);
+        cached = find_cache_key(filename, m_cacheKey) && load_cache(m_cacheKey, m_contours, m_trees);
+    }
+    if (cached) {
+        m_statistics.set(Statistics::COUNTER_BYTES_READ, FileSize(m_cacheKey.file));
+        NEUROLUCIDA_LOGN(LOG_SUMMARY, "loaded document from cache '" << m_cacheKey.file << "'");
+        m_cacheKey = CacheKey();
+        build_document(m_contours, m_trees);
+        return;
+    }
+
+    m_statistics.set(Statistics::COUNTER_BYTES_READ, FileSize(filename));
+
+    /// compressed files are decompressed into a copy
+    if (m_bMemoryMapped && compression == COMPRESSION_NONE && parse_file_mapped(filename)) {
+        process_document();
+        return;
+    }
+
+    /// a copy of the file is parsed, hence a mapped input is not valid anymore
+    release_input();
+    parse_buffer(read_file(filename));
+
+    NEUROLUCIDA_LOGN(LOG_SUMMARY, "processed document!");
+    process_document();
+}
+
+char* Neurolucida::read_file(const std::string& filename) {
+    Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_READ);
+    if (CompressionOfFile(filename) != COMPRESSION_NONE) {
+        InputFile in;
+        UG_COND_THROW(!in.open(filename), "Could not open file '" << filename << "'.");
+
+        /// the decompressed size is not known in advance
+        std::string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        UG_COND_THROW(!in.ok(), "Could not decompress file '" << filename << "'.");
+        char* fileContent = m_doc.allocate_string(0, content.size() + 1);
+        content.copy(fileContent, content.size());
+        fileContent[content.size()] = 0;
+        return fileContent;
+    }
+
     ifstream in(filename.c_str(), ios::binary);
-    if (!in) return;
+    UG_COND_THROW(!in, "Could not open file '" << filename << "'.");
 
     streampos posStart = in.tellg();
     in.seekg(0, ios_base::end);
@@ -64,8 +150,560 @@ void Neurolucida::parse_file(const std::string& filename) {
     in.read(fileContent, size);
     fileContent[size] = 0;
     in.close();
-    m_doc.parse<0>(fileContent);
+    return fileContent;
+}
 
-    UG_LOGN("processed document!");
-    process_document();
+bool Neurolucida::parse_file_mapped(const std::string& filename) {
+    Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_READ);
+    /// same unchanged file converted again: reuse mapping and DOM
+    if (m_mappedFile.is_current(filename)) {
+        NEUROLUCIDA_LOGN(LOG_SUMMARY, "reusing mapped document!");
+        return true;
+    }
+
+    release_input();
+    if (!m_mappedFile.open(filename)) {
+        NEUROLUCIDA_LOGN(LOG_SUMMARY, "Could not map file '" << filename << "', falling back to reading a copy.");
+        return false;
+    }
+
+    /// rapidxml needs a zero terminated input, only available without a copy
+    /// if the mapping does not end exactly at a page boundary
+    if (!m_mappedFile.is_zero_terminated()) {
+        NEUROLUCIDA_LOGN(LOG_SUMMARY, "Mapped file '" << filename << "' is not zero terminated, falling back to reading a copy.");
+        m_mappedFile.close();
+        return false;
+    }
+
+    /// the non-destructive parser does not write to the input
+    Statistics::ScopedPhase parsePhase(m_statistics, Statistics::PHASE_PARSE);
+    m_doc.parse<rapidxml::parse_non_destructive>(const_cast<char*>(m_mappedFile.data()));
+    NEUROLUCIDA_LOGN(LOG_SUMMARY, "processed mapped document!");
+    return true;
+}
+
+namespace {
+	/*!
+	 * \brief state of the tree or branch currently read
+	 */
+	struct BranchFrame {
+		size_t depth; ///<! depth of the tree or branch tag
+		size_t last; ///<! index of the point new points of this branch are connected to
+		bool hasLast;
+	};
+}
+
+void Neurolucida::parse_file_streaming(const std::string& filename) {
+	/// reading is interleaved with parsing, the other phases are entered per element
+	Statistics::ScopedPhase parsePhase(m_statistics, Statistics::PHASE_PARSE);
+	InputFile in;
+	UG_COND_THROW(!in.open(filename), "Could not open file '" << filename << "'.");
+
+	XMLStreamReader reader(in);
+	if (reader.next() != XMLStreamReader::START_ELEMENT || reader.name() != "mbf") {
+		UG_LOG("XML file in wrong format, or no Neurolucida XML file provided!");
+		return;
+	}
+
+	/// only the current contour respectively tree is kept in memory
+	/// a single contour respectively tree is kept, reusing the memory of previous documents
+	m_contours.resize(1);
+	m_trees.resize(1);
+	Contour& contour = m_contours[0];
+	Tree& tree = m_trees[0];
+	bool inContour = false;
+	bool inTree = false;
+	size_t contourIndex = 1;
+	size_t treeIndex = 1;
+	std::vector<BranchFrame> branches;
+
+	bool buildGrid = needs_grid();
+	bool streamUGX = streams_ugx();
+	bool morphometrics = writes_morphometrics();
+	if (morphometrics) m_morphometrics.clear();
+	{
+		Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+		if (m_bConvertToSWC) open_swc();
+		if (streamUGX) open_ugx_stream();
+	}
+
+	XMLStreamReader::EventType event = reader.next();
+	while (event != XMLStreamReader::END_DOCUMENT) {
+		const std::string& name = reader.name();
+		if (event == XMLStreamReader::START_ELEMENT) {
+			if (reader.depth() == 2 && name == "contour") {
+				contour.clear();
+				const char* value = reader.attribute("name");
+				contour.name = value ? value : "N/A";
+				value = reader.attribute("closed");
+				contour.closed = value && strcmp(value, "false") != 0;
+				value = reader.attribute("color");
+				contour.color = value ? value : "";
+				NEUROLUCIDA_LOGN(LOG_ELEMENTS, "Contour name: '" << contour.name << "'");
+				inContour = true;
+			} else if (reader.depth() == 2 && name == "tree") {
+				tree.clear();
+				const char* value = reader.attribute("color");
+				tree.color = value ? value : "";
+				value = reader.attribute("leaf");
+				tree.leaf = value ? value : "N/A";
+				value = reader.attribute("type");
+				tree.type = value ? value : "N/A";
+				BranchFrame frame;
+				frame.depth = reader.depth();
+				frame.last = 0;
+				frame.hasLast = false;
+				branches.push_back(frame);
+				inTree = true;
+			} else if (inTree && name == "branch" && reader.depth() == branches.back().depth + 1) {
+				/// a branch starts at the point its parent reached so far
+				BranchFrame frame = branches.back();
+				frame.depth = reader.depth();
+				branches.push_back(frame);
+			} else if (name == "point") {
+				if (inContour && reader.depth() == 3) {
+					MathVector<4> point;
+					DecodePoint(reader, point);
+					contour.points.push_back(point);
+				} else if (inTree && reader.depth() == branches.back().depth + 1) {
+					MathVector<4> point;
+					DecodePoint(reader, point);
+					BranchFrame& frame = branches.back();
+					frame.last = add_point(tree, point, frame.hasLast, frame.last);
+					frame.hasLast = true;
+				}
+			}
+		} else {
+			if (inContour && reader.depth() == 1 && name == "contour") {
+				inContour = false;
+				m_statistics.add(Statistics::COUNTER_POINTS, contour.points.size());
+				if (!usable_contour(contour)) {
+					NEUROLUCIDA_LOGN(LOG_SUMMARY, "Contour '" << contour.name << "' has no edges and is skipped.");
+				} else {
+					if (m_bConvertToSWC || morphometrics) {
+						Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+						if (m_bConvertToSWC) write_swc_contour(contour);
+						if (morphometrics && contour.name == "Cell Body") m_morphometrics.add_soma(contour.points);
+					}
+					if (buildGrid || streamUGX) {
+						contour.points.scale(m_scaling);
+						int si = static_cast<int>(m_subsetCount++);
+						if (contour.name == "Cell Body") {
+							m_somaIndex = si;
+							m_bSomaAvailable = true;
+						}
+						if (buildGrid) {
+							Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_GRID);
+							create_contour(contour, contourIndex, si);
+						}
+						if (streamUGX) {
+							Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+							stream_contour(contour, contourIndex, si);
+						}
+					}
+					contourIndex++;
+				}
+			} else if (inTree && name == "branch" && reader.depth() + 1 == branches.back().depth) {
+				branches.pop_back();
+			} else if (inTree && reader.depth() == 1 && name == "tree") {
+				inTree = false;
+				branches.clear();
+				m_statistics.add(Statistics::COUNTER_POINTS, tree.points.size());
+				m_statistics.add(Statistics::COUNTER_TREE_EDGES, tree.edges.size());
+				if (!usable_tree(tree)) {
+					NEUROLUCIDA_LOGN(LOG_SUMMARY, "Tree with type: '" << tree.type << "' has no edges and is skipped.");
+				} else {
+					if (m_bConvertToSWC || morphometrics) {
+						Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+						if (m_bConvertToSWC) write_swc_tree(tree);
+						if (morphometrics) m_morphometrics.add_tree(tree.points, tree.edges);
+					}
+					if (buildGrid || streamUGX) {
+						{
+							Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_TREES);
+							if (simplifies()) m_numSimplifiedPoints += simplify_trees(&tree, 1);
+							prepare_tree(tree, treeIndex);
+						}
+						int si = static_cast<int>(m_subsetCount++);
+						if (buildGrid) {
+							Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_GRID);
+							create_tree_vertices(tree, si);
+							create_tree_edges(tree, si);
+							set_tree_subset_name(tree, si);
+							set_tree_subset_color(tree, si);
+							m_treeRoots.push_back(std::make_pair(tree.points[tree.edges.front().from], si));
+						}
+						if (streamUGX) {
+							Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+							stream_tree(tree, si);
+						}
+					}
+					treeIndex++;
+				}
+			}
+		}
+		event = reader.next();
+	}
+	UG_COND_THROW(!in.ok(), "Could not decompress file '" << filename << "'.");
+
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "processed document (streaming)!");
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "#contours: " << contourIndex-1 << ", #trees: " << treeIndex-1);
+	if (simplifies()) NEUROLUCIDA_LOGN(LOG_SUMMARY, "simplification removed " << m_numSimplifiedPoints << " points of the trees");
+
+	{
+		Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+		if (m_bConvertToSWC) close_swc();
+		if (morphometrics) write_morphometrics();
+		if (streamUGX) close_ugx_stream();
+	}
+	if (!buildGrid) {
+		m_statistics.set(Statistics::COUNTER_SUBSETS, m_subsetCount);
+		return;
+	}
+
+	/// subsets are assigned consecutively, thus soma and tree subset indices
+	/// stay valid until the empty subsets are erased at the very end
+	{
+		Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_SOMA);
+		connect_to_soma();
+		EraseEmptySubsets(*m_s);
+	}
+	m_statistics.set(Statistics::COUNTER_SUBSETS, m_s->num_subsets());
+
+	save_output();
+}
+
+void Neurolucida::save_output() {
+	Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+	std::vector<ug::SmartPtr<OutputSink> > ownSinks;
+	/// save grid to obj if demanded
+	if (m_bConvertToOBJ) ownSinks.push_back(ug::make_sp(new OBJSink()));
+	/// save grid to ugx if demanded and not streamed
+	if (m_bConvertToUGX && !m_bStreamingOutput) ownSinks.push_back(ug::make_sp(new UGXSink()));
+	/// save the tube surface if demanded
+	if (m_surfaceFormat != SURFACE_NONE) ownSinks.push_back(ug::make_sp(new SurfaceSink(m_surfaceFormat, m_surfaceResolution, m_numThreads)));
+
+	/// added sinks are shared by the converters of a batch, their (non atomic)
+	/// reference counts are thus not touched while converting
+	std::vector<const OutputSink*> sinks;
+	for (size_t i = 0; i < ownSinks.size(); i++) {
+		sinks.push_back(ownSinks[i].get());
+	}
+	for (size_t i = 0; i < m_outputSinks.size(); i++) {
+		sinks.push_back(m_outputSinks[i].get());
+	}
+	if (sinks.empty()) return;
+
+	/// all formats are written from one traversal of the grid, each on its own thread
+	OutputGeometry geometry;
+	collect_output_geometry(geometry);
+	std::vector<std::future<bool> > written;
+	for (size_t i = 0; i < sinks.size(); i++) {
+		const OutputSink* sink = sinks[i];
+		std::string filename = output_file_name(sink->extension());
+		int compression = m_compression;
+		written.push_back(std::async(std::launch::async, [sink, &geometry, filename, compression]() {
+			return sink->write(geometry, filename, compression);
+		}));
+	}
+
+	/// all writes are completed before a failure is reported
+	std::vector<bool> success(sinks.size());
+	for (size_t i = 0; i < written.size(); i++) {
+		success[i] = written[i].get();
+	}
+
+	for (size_t i = 0; i < sinks.size(); i++) {
+		std::string filename = output_file_name(sinks[i]->extension());
+		UG_COND_THROW(!success[i], "Could not write file '" << filename << "'.");
+		m_statistics.add(Statistics::COUNTER_BYTES_WRITTEN, FileSize(filename));
+		NEUROLUCIDA_LOGN(LOG_SUMMARY, "written file '" << filename << "'");
+	}
+}
+
+void Neurolucida::collect_output_geometry(OutputGeometry& geometry) {
+	geometry.clear();
+	geometry.positions.reserve(m_g->num_vertices());
+	geometry.diameters.reserve(m_g->num_vertices());
+	geometry.vertexSubsets.reserve(m_g->num_vertices());
+	geometry.edges.reserve(m_g->num_edges());
+	geometry.edgeSubsets.reserve(m_g->num_edges());
+
+	/// index of each vertex of the grid
+	ug::AInt aIndex;
+	m_g->attach_to_vertices(aIndex);
+	ug::Grid::VertexAttachmentAccessor<ug::AInt> aaIndex(*m_g, aIndex);
+
+	for (ug::VertexIterator it = m_g->begin<ug::Vertex>(); it != m_g->end<ug::Vertex>(); ++it) {
+		aaIndex[*it] = static_cast<int>(geometry.positions.size());
+		geometry.positions.push_back(m_aaPos[*it]);
+		geometry.diameters.push_back(m_aaDiameter[*it]);
+		geometry.vertexSubsets.push_back(m_s->get_subset_index(*it));
+	}
+
+	for (ug::EdgeIterator it = m_g->begin<ug::Edge>(); it != m_g->end<ug::Edge>(); ++it) {
+		geometry.edges.push_back(std::make_pair(static_cast<size_t>(aaIndex[(*it)->vertex(0)]), static_cast<size_t>(aaIndex[(*it)->vertex(1)])));
+		geometry.edgeSubsets.push_back(m_s->get_subset_index(*it));
+	}
+
+	for (int si = 0; si < m_s->num_subsets(); si++) {
+		geometry.subsetNames.push_back(m_s->subset_info(si).name);
+		geometry.subsetColors.push_back(m_s->subset_info(si).color);
+	}
+
+	m_g->detach_from_vertices(aIndex);
+}
+
+void Neurolucida::open_swc() {
+	std::string filename = output_file_name(SWC_EXTENSION);
+	UG_COND_THROW(!m_swcWriter.open(filename, m_inputName, m_compression), "Could not open file '" << filename << "'.");
+}
+
+void Neurolucida::close_swc() {
+	UG_COND_THROW(!m_swcWriter.close(), "Could not write file '" << output_file_name(SWC_EXTENSION) << "'.");
+	m_statistics.add(Statistics::COUNTER_BYTES_WRITTEN, FileSize(output_file_name(SWC_EXTENSION)));
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "written SWC file '" << output_file_name(SWC_EXTENSION) << "'");
+}
+
+void Neurolucida::write_swc_contour(const Contour& contour) {
+	if (contour.name != "Cell Body") {
+		NEUROLUCIDA_LOGN(LOG_ELEMENTS, "Contour '" << contour.name << "' is not part of the SWC output.");
+		return;
+	}
+
+	long parent = SwcWriter::NO_PARENT;
+	for (size_t i = 0; i < contour.points.size(); i++) {
+		parent = m_swcWriter.write_soma_sample(contour.points[i], parent);
+	}
+}
+
+void Neurolucida::write_swc_tree(const Tree& t) {
+	if (t.edges.empty()) return;
+
+	/// parent of each point, given by the edge ending at the point
+	const size_t noParent = std::numeric_limits<size_t>::max();
+	std::vector<size_t> parents(t.points.size(), noParent);
+	std::vector<CEdge>::const_iterator it = t.edges.begin();
+	for (; it != t.edges.end(); ++it) {
+		parents[it->to] = it->from;
+	}
+
+	int type = SwcTypeOfTree(t.type);
+	std::vector<long> ids(t.points.size());
+	for (size_t i = 0; i < t.points.size(); i++) {
+		long parent = parents[i] == noParent ? m_swcWriter.closest_soma_sample(t.points[i]) : ids[parents[i]];
+		ids[i] = m_swcWriter.write_sample(type, t.points[i], parent);
+	}
+}
+
+void Neurolucida::write_morphometrics() {
+	m_morphometrics.finish();
+	bool json = m_morphometricsFormat == MORPHOMETRICS_JSON;
+	std::string filename = output_file_name(json ? MORPHOMETRICS_JSON_EXTENSION : MORPHOMETRICS_CSV_EXTENSION);
+	OutputFile out;
+	UG_COND_THROW(!out.open(filename, m_compression), "Could not open file '" << filename << "'.");
+	out << std::setprecision(std::numeric_limits<number>::digits10 + 1);
+	if (json) {
+		m_morphometrics.write_json(out);
+	} else {
+		m_morphometrics.write_csv(out);
+	}
+	UG_COND_THROW(!out.close(), "Could not write file '" << filename << "'.");
+	m_statistics.add(Statistics::COUNTER_BYTES_WRITTEN, FileSize(filename));
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "total length: " << m_morphometrics.total_length() << ", surface area: "
+		<< m_morphometrics.surface_area() << ", volume: " << m_morphometrics.volume());
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "written morphometrics file '" << filename << "'");
+}
+
+void Neurolucida::convert_in_memory(const std::string& filename) {
+	OutputSettings settings;
+	disable_output(settings);
+	set_output_name(filename);
+	try {
+		parse_file(filename);
+	} catch (...) {
+		restore_output(settings);
+		throw;
+	}
+	restore_output(settings);
+}
+
+ug::SmartPtr<ug::Domain3d> Neurolucida::convert_to_domain(const std::string& filename) {
+	convert_in_memory(filename);
+	ug::SmartPtr<ug::Domain3d> dom = ug::make_sp(new ug::Domain3d());
+	copy_to_domain(*dom);
+	return dom;
+}
+
+void Neurolucida::copy_to_domain(ug::Domain3d& dom) {
+	ug::MultiGrid& mg = *dom.grid();
+	ug::MGSubsetHandler& sh = *dom.subset_handler();
+	ug::Domain3d::position_accessor_type& aaPos = dom.position_accessor();
+
+	ug::ANumber aDiameter = ug::GlobalAttachments::attachment<ug::ANumber>("diameter");
+	if (!mg.has_vertex_attachment(aDiameter)) {
+		mg.attach_to_vertices(aDiameter);
+	}
+	ug::Grid::VertexAttachmentAccessor<ug::ANumber> aaDiameter(mg, aDiameter);
+
+	/// copy of each vertex of the grid
+	ug::AVertex aCopy;
+	m_g->attach_to_vertices(aCopy);
+	ug::Grid::VertexAttachmentAccessor<ug::AVertex> aaCopy(*m_g, aCopy);
+
+	for (ug::VertexIterator it = m_g->begin<ug::Vertex>(); it != m_g->end<ug::Vertex>(); ++it) {
+		ug::Vertex* vtx = *mg.create<ug::RegularVertex>();
+		aaPos[vtx] = m_aaPos[*it];
+		aaDiameter[vtx] = m_aaDiameter[*it];
+		aaCopy[*it] = vtx;
+		int si = m_s->get_subset_index(*it);
+		if (si >= 0) sh.assign_subset(vtx, si);
+	}
+
+	for (ug::EdgeIterator it = m_g->begin<ug::Edge>(); it != m_g->end<ug::Edge>(); ++it) {
+		ug::Edge* edge = *mg.create<ug::RegularEdge>(ug::EdgeDescriptor(aaCopy[(*it)->vertex(0)], aaCopy[(*it)->vertex(1)]));
+		int si = m_s->get_subset_index(*it);
+		if (si >= 0) sh.assign_subset(edge, si);
+	}
+
+	for (int si = 0; si < m_s->num_subsets(); si++) {
+		sh.subset_info(si) = m_s->subset_info(si);
+	}
+
+	m_g->detach_from_vertices(aCopy);
+	dom.update_subset_infos(0);
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "copied " << m_g->num_vertices() << " vertices and " << m_g->num_edges() << " edges to the domain");
+}
+
+void Neurolucida::open_ugx_stream() {
+	std::string filename = output_file_name(UGX_EXTENSION);
+	UG_COND_THROW(!m_ugxWriter.open(filename, m_compression), "Could not open file '" << filename << "'.");
+	m_streamedSoma = StreamedSoma();
+}
+
+void Neurolucida::stream_contour(const Contour& contour, size_t contourIndex, int si) {
+	ug::MathVector<4> color;
+	get_subset_color(contour.color, color);
+	m_ugxWriter.set_subset_info(si, contour_subset_name(contour, contourIndex), color);
+
+	/// as for the grid the last soma contour is the soma, previous ones are written as they are
+	bool soma = contour.name == "Cell Body";
+	if (soma) {
+		for (size_t i = 0; i < m_streamedSoma.segments.size(); i++) {
+			m_ugxWriter.edge(m_streamedSoma.segments[i].from, m_streamedSoma.segments[i].to, m_streamedSoma.si);
+		}
+		m_streamedSoma.si = si;
+		m_streamedSoma.vertices.clear();
+		m_streamedSoma.positions.clear();
+		m_streamedSoma.segments.clear();
+	}
+
+	/// same points and diameters as create_contour
+	size_t numEdges = num_contour_edges(contour);
+
+	/// vertices are counted for the grid if one is created as well
+	if (!needs_grid()) m_statistics.add(Statistics::COUNTER_VERTICES_REQUESTED, 2 * numEdges);
+	for (size_t i = 0; i < numEdges; i++) {
+		bool created, created2;
+		ug::vector3 pos = contour.points.position(i);
+		ug::vector3 pos2 = contour.points.position(i+1);
+		size_t vtx = m_ugxWriter.vertex(pos, contour.points.diameter(i), si, created);
+		size_t vtx2 = m_ugxWriter.vertex(pos2, contour.points.diameter(i), si, created2);
+		if (!soma) {
+			m_ugxWriter.edge(vtx, vtx2, si);
+			continue;
+		}
+
+		/// soma edges are kept, since they may be split when the trees are attached
+		if (created) {
+			m_streamedSoma.vertices.push_back(vtx);
+			m_streamedSoma.positions.push_back(pos);
+		}
+		if (created2) {
+			m_streamedSoma.vertices.push_back(vtx2);
+			m_streamedSoma.positions.push_back(pos2);
+		}
+		if (vtx != vtx2) {
+			SomaIndex<size_t>::Segment segment;
+			segment.from = vtx;
+			segment.to = vtx2;
+			segment.fromPos = pos;
+			segment.toPos = pos2;
+			m_streamedSoma.segments.push_back(segment);
+		}
+	}
+}
+
+void Neurolucida::stream_tree(const Tree& t, int si) {
+	m_ugxWriter.set_subset_info(si, t.subsetName, t.subsetColor);
+
+	std::vector<size_t> vertices(t.points.size());
+	if (!needs_grid()) m_statistics.add(Statistics::COUNTER_VERTICES_REQUESTED, t.points.size());
+	for (size_t i = 0; i < t.points.size(); i++) {
+		bool created;
+		vertices[i] = m_ugxWriter.vertex(t.points.position(i), t.points.diameter(i), si, created);
+	}
+
+	std::vector<CEdge>::const_iterator it = t.edges.begin();
+	for (; it != t.edges.end(); ++it) {
+		m_ugxWriter.edge(vertices[it->from], vertices[it->to], si);
+	}
+
+	if (!t.edges.empty()) {
+		m_streamedSoma.treeRoots.push_back(std::make_pair(t.points[t.edges.front().from], si));
+	}
+}
+
+void Neurolucida::close_ugx_stream() {
+	StreamedSoma& soma = m_streamedSoma;
+	SomaIndex<size_t> index;
+	index.build(soma.vertices, soma.positions, soma.segments);
+
+	/// same attachment as connect_root_to_soma
+	if (soma.si >= 0) {
+		std::vector<std::pair<MathVector<4>, int> >::const_iterator it = soma.treeRoots.begin();
+		for (; it != soma.treeRoots.end(); ++it) {
+			ug::vector3 pos(it->first.coord(0), it->first.coord(1), it->first.coord(2));
+			size_t closest;
+			bool found;
+			size_t segment;
+			ug::vector3 closestPos;
+			number t;
+			if (m_somaAttachment == SOMA_ATTACH_EDGE && index.closest_segment(pos, segment, closestPos, t)) {
+				/// only the ends of the soma edge are reused, any other vertex there (e.g. the root) splits it
+				found = true;
+				if (!index.segment_end(segment, closestPos, REMOVE_DOUBLE_THRESHOLD, closest)) {
+					/// split the soma edge at the attachment point, at the root itself if it lies on the edge
+					SomaIndex<size_t>::Segment s = index.segment(segment);
+					number diameter = (1 - t) * m_ugxWriter.diameter(s.from) + t * m_ugxWriter.diameter(s.to);
+					bool created;
+					closest = m_ugxWriter.vertex(closestPos, diameter, soma.si, created);
+					index.split_segment(segment, closest, closestPos);
+				}
+			} else {
+				found = index.closest_vertex(pos, closest);
+			}
+			if (!found) continue;
+
+			bool created;
+			size_t root = m_ugxWriter.vertex(pos, it->first.coord(3), -1, created);
+			if (!needs_grid()) m_statistics.add(Statistics::COUNTER_VERTICES_REQUESTED, 1);
+			m_ugxWriter.edge(root, closest, it->second);
+		}
+	}
+
+	for (size_t i = 0; i < index.num_segments(); i++) {
+		m_ugxWriter.edge(index.segment(i).from, index.segment(i).to, soma.si);
+	}
+
+	size_t numVertices = m_ugxWriter.num_vertices();
+	size_t numEdges = m_ugxWriter.num_edges();
+	UG_COND_THROW(!m_ugxWriter.close(), "Could not write file '" << output_file_name(UGX_EXTENSION) << "'.");
+	m_statistics.add(Statistics::COUNTER_BYTES_WRITTEN, FileSize(output_file_name(UGX_EXTENSION)));
+	if (!needs_grid()) {
+		m_statistics.set(Statistics::COUNTER_VERTICES, numVertices);
+		m_statistics.set(Statistics::COUNTER_EDGES, numEdges);
+	}
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "written UGX file '" << output_file_name(UGX_EXTENSION) << "' with " << numVertices << " vertices and " << numEdges << " edges");
+	m_streamedSoma = StreamedSoma();
 }
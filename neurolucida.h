@@ -35,9 +35,8 @@
  * \file neurolucida.h
  *
  * TODO:
- * 			   1. dont duplicate vertices... can be done without duplicating them
- * 			   2. dont store edges maybe? as we dont need them really we can omit storing them
- * 			   3. document and cleanup this code -> move to NETI finally if new UG available
+ * 			   1. dont store edges maybe? as we dont need them really we can omit storing them
+ * 			   2. document and cleanup this code -> move to NETI finally if new UG available
  *
  *  Created on: Jan 6, 2016
  *      Author: Stephan Grein
@@ -46,7 +45,9 @@
 #ifndef __H__UG__NEUEROLUCIDA__NEUROLUCIDA__
 #define __H__UG__NEUEROLUCIDA__NEUROLUCIDA__
 
+#include <memory>
 #include <string>
+#include <stdint.h>
 
 #include <common/parser/rapidxml/rapidxml.hpp>
 #include <common/math/ugmath.h>
@@ -56,12 +57,80 @@
 #include "lib_grid/attachments/attachment_info_traits.h"
 #include "lib_grid/attachments/attachment_io_traits.h"
 #include "lib_grid/global_attachments.h"
+#include "lib_disc/domain.h"
+
+#include "neurolucida_apposition.h"
+#include "neurolucida_block_pool.h"
+#include "neurolucida_compression.h"
+#include "neurolucida_mapped_file.h"
+#include "neurolucida_morphometrics.h"
+#include "neurolucida_output_sink.h"
+#include "neurolucida_point_decoder.h"
+#include "neurolucida_point_store.h"
+#include "neurolucida_soma_index.h"
+#include "neurolucida_statistics.h"
+#include "neurolucida_surface.h"
+#include "neurolucida_swc_writer.h"
+#include "neurolucida_thread_pool.h"
+#include "neurolucida_ugx_writer.h"
+#include "neurolucida_vertex_hash.h"
+
+/// logs the message if the log level of the converter is at least the given level
+#define NEUROLUCIDA_LOGN(level, msg) do {if (m_logLevel >= (level)) UG_LOGN(msg);} while (0)
 
 namespace ug {
 	namespace neurolucida {
 		class Neurolucida {
+		public:
+			/*!
+			 * \brief where trees are attached to the soma
+			 */
+			enum SomaAttachment {
+				SOMA_ATTACH_VERTEX = 0, ///<! closest soma vertex
+				SOMA_ATTACH_EDGE = 1 ///<! closest point on a soma edge
+			};
+
+			/*!
+			 * \brief verbosity of the conversion
+			 */
+			enum LogLevel {
+				LOG_SILENT = 0, ///<! errors only
+				LOG_SUMMARY = 1, ///<! one summary per document
+				LOG_ELEMENTS = 2 ///<! every contour, tree, branch and point
+			};
+
+			/*!
+			 * \brief how the elements of a network are distributed to the partitions
+			 */
+			enum NetworkPartitioning {
+				PARTITION_CELLS = 0, ///<! whole cells, balanced by their number of vertices
+				PARTITION_SPATIAL = 1 ///<! recursive coordinate bisection of the edges
+			};
+
+			/*!
+			 * \brief format of the morphometrics summary
+			 */
+			enum MorphometricsFormat {
+				MORPHOMETRICS_NONE = 0, ///<! no summary
+				MORPHOMETRICS_CSV = 1, ///<! metric,value lines
+				MORPHOMETRICS_JSON = 2 ///<! JSON object
+			};
+
+			/*!
+			 * \brief format of the tube surface mesh
+			 */
+			enum SurfaceFormat {
+				SURFACE_NONE = 0, ///<! no surface
+				SURFACE_OBJ = SurfaceSink::FORMAT_OBJ, ///<! Wavefront OBJ
+				SURFACE_UGX = SurfaceSink::FORMAT_UGX ///<! UGX with triangles
+			};
+
 		private:
 			rapidxml::xml_document<> m_doc;
+			MappedFile m_mappedFile; ///<! input the DOM of the memory mapped mode refers to
+			VertexHash m_vertexHash; ///<! vertices created so far by position
+			UGXStreamWriter m_ugxWriter; ///<! UGX output written without a grid
+			std::vector<std::pair<MathVector<4>, int> > m_treeRoots; ///<! first (scaled) point and subset of each tree
 			size_t m_subsetCount;
 			size_t m_somaIndex;
 
@@ -74,23 +143,89 @@ namespace ug {
 			static number REMOVE_DOUBLE_THRESHOLD;
 			static std::string UGX_EXTENSION;
 			static std::string OBJ_EXTENSION;
+			static std::string SWC_EXTENSION;
+			static std::string MORPHOMETRICS_CSV_EXTENSION;
+			static std::string MORPHOMETRICS_JSON_EXTENSION;
+			static std::string STATISTICS_EXTENSION;
 			static int DEFAULT_SUBSET_COLOR;
 
 			bool m_bConvertToUGX;
 			bool m_bConvertToOBJ;
+			bool m_bConvertToSWC; ///<! write SWC directly from the parsed trees
 			bool m_bSomaAvailable;
 			bool m_bVRLOutputNames;
+			bool m_bStreaming; ///<! read the file tag by tag instead of building a DOM
+			bool m_bMemoryMapped; ///<! parse a read-only mapping of the file instead of a copy
+			bool m_bStreamingOutput; ///<! write UGX while converting instead of from a grid
+			int m_logLevel; ///<! one of LogLevel
+			int m_somaAttachment; ///<! one of SomaAttachment
+			int m_compression; ///<! one of Compression, applied to all output files
+			size_t m_numThreads; ///<! threads for the per tree work, 0 for all hardware threads
+			std::unique_ptr<ThreadPool> m_threadPool; ///<! created on first use
 
 			ug::MathVector<4> m_defaultSubsetColor;
+			std::string m_inputName;
 			std::string m_outputName;
+			SwcWriter m_swcWriter;
 			std::string m_separator; ///<! output separator for subset names
 			number m_scaling; ///<! assumes micrometer and scales to meter
+			std::string m_cacheDirectory; ///<! directory of the binary cache, empty if disabled
+			number m_simplifyPositionTolerance; ///<! in the units of the file, 0 disables
+			number m_simplifyDiameterTolerance; ///<! in the units of the file, 0 disables
+			size_t m_numSimplifiedPoints; ///<! points removed by the simplification of the current document
+			int m_morphometricsFormat; ///<! one of MorphometricsFormat
+			Morphometrics m_morphometrics; ///<! of the current document, computed from the parsed trees
+			bool m_bStatisticsOutput; ///<! write the statistics of each document as JSON
+			Statistics m_statistics; ///<! of the current document
+			std::vector<SmartPtr<OutputSink> > m_outputSinks; ///<! output formats in addition to UGX and OBJ
+			int m_surfaceFormat; ///<! one of SurfaceFormat
+			size_t m_surfaceResolution; ///<! vertices per ring of the tube surface
+
+			/*!
+			 * \brief cache entry of the document being converted
+			 */
+			struct CacheKey {
+				std::string file; ///<! empty if the document is not cached
+				uint64_t contentHash; ///<! names the cache file
+				uint64_t contentCheck; ///<! independent hash verified before the cache file is used
+				uint64_t sourceSize;
+
+				CacheKey() : contentHash(0),
+							 contentCheck(0),
+							 sourceSize(0) {
+				}
+			};
+
+			CacheKey m_cacheKey;
+
+			/*!
+			 * \brief soma and tree roots of the UGX output written without a grid
+			 */
+			struct StreamedSoma {
+				int si; ///<! subset of the soma, -1 if there is none yet
+				std::vector<size_t> vertices;
+				std::vector<ug::vector3> positions;
+				std::vector<SomaIndex<size_t>::Segment> segments; ///<! soma edges, written at the end
+				std::vector<std::pair<MathVector<4>, int> > treeRoots;
+
+				StreamedSoma() : si(-1) {
+				}
+			};
+
+			StreamedSoma m_streamedSoma;
+
+			/// parsed points are stored in single precision if NEUROLUCIDA_FLOAT_POINTS is defined
+#ifdef NEUROLUCIDA_FLOAT_POINTS
+			typedef PointStore<float> Points;
+#else
+			typedef PointStore<number> Points;
+#endif
 
 			/*!
 			 * \brief NL contour
 			 */
 			struct Contour {
-				std::vector<MathVector<4> > points;
+				Points points;
 				std::string name;
 				std::string color;
 				bool closed;
@@ -99,45 +234,111 @@ namespace ug {
 							color(""),
 							closed(false) {
 				}
+
+				/*!
+				 * \brief resets the contour for the next document, the capacity is kept
+				 */
+				void clear() {
+					points.clear();
+					name = "N/A";
+					color = "";
+					closed = false;
+				}
+			};
+
+			/*!
+			 * \brief outcome of the conversion of one file in a batch
+			 */
+			struct BatchResult {
+				std::string filename;
+				bool success;
+				std::string message;
+				double seconds;
+				size_t points; ///<! parsed points, see Statistics::COUNTER_POINTS
+				size_t bytesWritten; ///<! size of all output files
+
+				BatchResult() : success(false),
+								seconds(0),
+								points(0),
+								bytesWritten(0) {
+				}
 			};
 
+			std::vector<BatchResult> m_batchResults;
+
 			/*!
-			 * \brief NL edge
+			 * \brief NL edge given by the indices of its points in Tree::points
 			 */
 			struct CEdge {
-				ug::MathVector<4> from;
-				ug::MathVector<4> to;
+				size_t from;
+				size_t to;
 			};
 
 			/*!
 			 * \brief NL tree
 			 */
 			struct Tree {
-				std::vector<MathVector<4> > points;
+				Points points;
 				std::string type;
 				std::string leaf;
 				std::string color;
 				std::vector<CEdge> edges;
+				std::string subsetName; ///<! set by prepare_tree
+				ug::MathVector<4> subsetColor; ///<! set by prepare_tree
 
 				Tree() : type("N/A"),
 						 leaf("N/A"),
 						 color("") {
 				}
+
+				/*!
+				 * \brief resets the tree for the next document, the capacity is kept
+				 */
+				void clear() {
+					points.clear();
+					type = "N/A";
+					leaf = "N/A";
+					color = "";
+					edges.clear();
+					subsetName.clear();
+				}
 			};
 
+			/// contours and trees of the current document, kept to reuse their memory
+			std::vector<Contour> m_contours;
+			std::vector<Tree> m_trees;
+
 		public:
 			/*!
 			 * \brief default ctor
 			 */
-			Neurolucida() : m_subsetCount(0),
+			Neurolucida() : m_vertexHash(REMOVE_DOUBLE_THRESHOLD),
+							m_ugxWriter(REMOVE_DOUBLE_THRESHOLD),
+							m_subsetCount(0),
 							m_somaIndex(0),
 							m_g(new ug::Grid()),
 							m_s(new SubsetHandler(*m_g)),
 							m_bConvertToUGX(false),
 							m_bConvertToOBJ(false),
+							m_bConvertToSWC(false),
 							m_bSomaAvailable(false),
 							m_bVRLOutputNames(true),
-							m_scaling(1e-6) {
+							m_bStreaming(false),
+							m_bMemoryMapped(false),
+							m_bStreamingOutput(false),
+							m_logLevel(LOG_SUMMARY),
+							m_somaAttachment(SOMA_ATTACH_VERTEX),
+							m_compression(COMPRESSION_NONE),
+							m_numThreads(1),
+							m_scaling(1e-6),
+							m_simplifyPositionTolerance(0),
+							m_simplifyDiameterTolerance(0),
+							m_numSimplifiedPoints(0),
+							m_morphometricsFormat(MORPHOMETRICS_NONE),
+							m_bStatisticsOutput(false),
+							m_surfaceFormat(SURFACE_NONE),
+							m_surfaceResolution(8),
+							m_bNetworkAssembled(false) {
 
 					if (!m_g->has_vertex_attachment(ug::aPosition)) {
 						m_g->attach_to_vertices(ug::aPosition);
@@ -160,101 +361,189 @@ namespace ug {
 
 					m_separator = "";
 
+					/// blocks of the DOM are recycled when the next document is parsed
+					m_doc.set_allocator(BlockPoolAllocate, BlockPoolFree);
+
 			}
 
 			/*!
 			 * \brief default dtor
 			 */
 			~Neurolucida() {
+				m_partitions.reset();
 				delete m_s;
 				delete m_g;
 			}
 
 		protected:
-			void process_trees() {
+			/*!
+			 * \brief scales the points of all contours by m_scaling
+			 */
+			void scale_points(std::vector<Contour>& contours) const {
+				std::vector<Contour>::iterator it = contours.begin();
+				for (; it != contours.end(); ++it) {
+					it->points.scale(m_scaling);
+				}
+			}
+
+			/*!
+			 * \brief scales the points of the trees and determines their subset names and colors
+			 * Trees are simplified before, if enabled, and prepared in parallel, see set_num_threads.
+			 */
+			void prepare_trees(std::vector<Tree>& trees) {
+				if (simplifies() && !trees.empty()) {
+					m_numSimplifiedPoints += simplify_trees(&trees[0], trees.size());
+					NEUROLUCIDA_LOGN(LOG_SUMMARY, "simplification removed " << m_numSimplifiedPoints << " points of the trees");
+				}
+				parallel_for(trees.size(), [this, &trees](size_t i) {
+					prepare_tree(trees[i], i+1);
+				});
+			}
+
+		private:
+			/*!
+			 * \brief reads all trees of the document
+			 */
+			void read_trees(std::vector<Tree>& trees) {
 				rapidxml::xml_node<>* rootNode = m_doc.first_node();
-				std::vector<Tree> trees;
 
 				if (rootNode) {
-					if (strcmp(rootNode->name(), "mbf") != 0) {
+					if (!has_name(rootNode, "mbf")) {
 						UG_LOG("XML file in wrong format, or no Neurolucida XML file provided!");
 					} else {
+						/// trees are independent, thus read in parallel into their slots
+						std::vector<const rapidxml::xml_node<>*> treeNodes;
 						rapidxml::xml_node<>* treeData = rootNode->first_node("tree");
 						while (treeData) {
-							Tree t;
-							rapidxml::xml_node<>* pointData = treeData->first_node("point");
-							while (pointData) {
-								number x = atof(pointData->first_attribute("x")->value());
-								number y = atof(pointData->first_attribute("y")->value());
-								number z = atof(pointData->first_attribute("z")->value());
-								number d = atof(pointData->first_attribute("d")->value());
-								MathVector<4> point(x, y, z, d);
-								t.points.push_back(point);
-								pointData = pointData->next_sibling("point");
-								UG_LOGN("x: " << x << ", " << "y: " << y << ", z: " << z << ", d:" << d);
-							}
-
-							for (size_t i = 0; i < t.points.size()-1; i++) {
-								CEdge e;
-								e.from = t.points[i];
-								e.to = t.points[i+1];
-								t.edges.push_back(e);
-							}
-
-							rapidxml::xml_node<>* branchData = treeData->first_node("branch");
-							MathVector<4> point_before_branch = t.points[t.points.size()-1];
-
-							if (branchData) {
-								/// process branches of given tree
-								UG_LOGN("tree with type: '" << treeData->first_attribute("type")->value() << "' has branches!");
-								t.color = treeData->first_attribute("color")->value();
-								t.leaf = treeData->first_attribute("leaf")->value();
-								t.type = treeData->first_attribute("type")->value();
-								process_branch(t, branchData, point_before_branch);
-							} else {
-								/// process branches in case we have no branches
-								UG_LOGN("tree with type: '" << treeData->first_attribute("type")->value() << "' has no branches!");
-								t.color = treeData->first_attribute("color")->value();
-								t.leaf = treeData->first_attribute("leaf")->value();
-								t.type = treeData->first_attribute("type")->value();
-								process_branch(t, branchData, point_before_branch);
-							}
-
-							/// store the tree information
-							trees.push_back(t);
-
-							/// and next tree
+							treeNodes.push_back(treeData);
 							treeData = treeData->next_sibling("tree");
 						}
+
+						trees.resize(treeNodes.size());
+						parallel_for(trees.size(), [this, &trees, &treeNodes](size_t i) {
+							read_tree(treeNodes[i], trees[i]);
+						});
 					}
 				} else {
 					UG_LOGN("Error during parsing XML document.")
 				}
+			}
+
+			/*!
+			 * \brief reads the points, branches and attributes of a tree
+			 */
+			void read_tree(const rapidxml::xml_node<>* treeData, Tree& t) const {
+				t.clear();
+				rapidxml::xml_node<>* pointData = treeData->first_node("point");
+				while (pointData) {
+					MathVector<4> point;
+					DecodePoint(pointData, point);
+					add_point(t, point, !t.points.empty(), t.points.size()-1);
+					pointData = pointData->next_sibling("point");
+					NEUROLUCIDA_LOGN(LOG_ELEMENTS, "x: " << point[0] << ", " << "y: " << point[1] << ", z: " << point[2] << ", d:" << point[3]);
+				}
+
+				t.color = attribute_string(treeData, "color", "");
+				t.leaf = attribute_string(treeData, "leaf", "N/A");
+				t.type = attribute_string(treeData, "type", "N/A");
+
+				rapidxml::xml_node<>* branchData = treeData->first_node("branch");
+				if (branchData) {
+					/// process branches of given tree, starting at the last point of the tree
+					NEUROLUCIDA_LOGN(LOG_ELEMENTS, "tree with type: '" << t.type << "' has branches!");
+					process_branches(t, branchData, !t.points.empty(), t.points.size()-1);
+				} else {
+					NEUROLUCIDA_LOGN(LOG_ELEMENTS, "tree with type: '" << t.type << "' has no branches!");
+				}
+			}
+
+			/*!
+			 * \brief scales the points of the tree and determines its subset name and color
+			 * \param[in] treeIndex 1-based index of the tree used in the subset name
+			 */
+			void prepare_tree(Tree& t, size_t treeIndex) const {
+				t.points.scale(m_scaling);
+				t.subsetName = tree_subset_name(t, treeIndex);
+				get_subset_color(t.color, t.subsetColor);
+				NEUROLUCIDA_LOGN(LOG_ELEMENTS, "it->color: " << t.color);
+			}
+
+			/*!
+			 * \brief calls body(i) for all i in [0, n), e.g. trees or branches, in
+			 * parallel if more than one thread is used
+			 * Logging every element keeps the work serial to keep the log in order.
+			 */
+			void parallel_for(size_t n, const std::function<void (size_t)>& body) {
+				if (m_numThreads == 1 || n < 2 || m_logLevel >= LOG_ELEMENTS) {
+					for (size_t i = 0; i < n; i++) {
+						body(i);
+					}
+					return;
+				}
+
+				if (!m_threadPool) {
+					m_threadPool.reset(new ThreadPool(m_numThreads));
+				}
+				ParallelFor(*m_threadPool, n, body);
+			}
+
+			/*!
+			 * \brief unbranched part of a tree between two points which have to be kept
+			 */
+			struct Branch {
+				size_t tree; ///<! index of the tree
+				std::vector<size_t> points; ///<! point indices from the first to the last point
+			};
 
+			/*!
+			 * \brief checks if trees are simplified, see set_simplification
+			 */
+			inline bool simplifies() const {
+				return m_simplifyPositionTolerance > 0 || m_simplifyDiameterTolerance > 0;
+			}
+
+			/*!
+			 * \brief simplifies the branches of the trees, in parallel across all branches
+			 * \return number of removed points
+			 */
+			size_t simplify_trees(Tree* trees, size_t numTrees);
+
+			/*!
+			 * \brief collects the branches of a tree
+			 * Branches end at branch points, tree roots and leaves, i.e. at all
+			 * points without exactly one incoming and one outgoing edge.
+			 */
+			void collect_branches(const Tree& t, size_t treeIndex, std::vector<Branch>& branches) const;
+
+			/*!
+			 * \brief Douglas-Peucker simplification of a branch
+			 * Keeps the inner points of the branch needed to approximate positions
+			 * and diameters within the tolerances by linear interpolation.
+			 * \param[out] keep flags of the inner points of the branch
+			 */
+			void simplify_branch(const Points& points, const std::vector<size_t>& branch, std::vector<char>& keep) const;
+
+			/*!
+			 * \brief removes the points of a tree which are not kept
+			 * Edges are redirected across removed points, keeping their direction and order.
+			 * \return number of removed points
+			 */
+			size_t remove_points(Tree& t, const std::vector<char>& keep) const;
+
+			/*!
+			 * \brief creates the geometry of all prepared trees
+			 * The elements are created serially in the order of the trees, thus the
+			 * grid does not depend on the number of threads used to prepare the trees.
+			 */
+			void create_trees(const std::vector<Tree>& trees) {
 				size_t treeIndex = 1;
-				UG_LOGN("#trees: " << trees.size());
+				NEUROLUCIDA_LOGN(LOG_SUMMARY, "#trees: " << trees.size());
 				std::vector<Tree>::const_iterator it = trees.begin();
 
 				/// create vertices
 				for (; it != trees.end(); ++it) {
-					std::vector<MathVector<4> >::const_iterator it2 = it->points.begin();
-					UG_LOGN("#points of tree: " << it->points.size());
-					for (;it2 != it->points.end();) {
-						ug::RegularVertex* vtx =  *(m_g->create<ug::RegularVertex>());
-						m_aaPos[vtx] = ug::vector3(it2->coord(0) * m_scaling, it2->coord(1) * m_scaling, it2->coord(2) * m_scaling);
-						m_aaDiameter[vtx] = it2->coord(3) * m_scaling;
-						m_s->assign_subset(vtx, treeIndex+m_subsetCount);
-						++it2;
-					}
-					std::stringstream ss;
-					if (!m_bVRLOutputNames) {
-						ss << "Tree" << m_separator << treeIndex << ":" << m_separator << "'" << it->type << "'" << m_separator << "(" << "Leaf:" << m_separator << "'" << it->leaf << "')";
-					} else {
-						std::string str = it->type;
-						str.erase(remove_if(str.begin(), str.end(), isspace), str.end());
-						ss << "Tree" << "_" << treeIndex << "_" << str << "_" << it->leaf;
-					}
-					m_s->subset_info(treeIndex+m_subsetCount).name = ss.str();
+					create_tree_vertices(*it, treeIndex+m_subsetCount);
+					set_tree_subset_name(*it, treeIndex+m_subsetCount);
 					treeIndex++;
 				}
 
@@ -262,155 +551,171 @@ namespace ug {
 				treeIndex = 1;
 				it = trees.begin();
 				for (; it != trees.end(); ++it) {
-					typedef std::vector<CEdge>::const_iterator IT2;
-					IT2 it2;
-					it2 = it->edges.begin();
-					UG_LOGN("#edges of tree:" << it->edges.size());
-					for (; it2 != it->edges.end(); ++it2) {
-						ug::RegularVertex* vtx =  *(m_g->create<ug::RegularVertex>());
-						ug::RegularVertex* vtx2 =  *(m_g->create<ug::RegularVertex>());
-						const CEdge* e = &(*it2);
-						m_aaPos[vtx] = ug::vector3(m_scaling * e->from.coord(0), m_scaling * e->from.coord(1), m_scaling * e->from.coord(2));
-						m_aaPos[vtx2] = ug::vector3(m_scaling * e->to.coord(0), m_scaling * e->to.coord(1), m_scaling * e->to.coord(2));
-						ug::RegularEdge* edge = (*m_g->create<ug::RegularEdge>(EdgeDescriptor(vtx, vtx2)));
-						m_s->assign_subset(edge, treeIndex+m_subsetCount);
-					}
+					create_tree_edges(*it, treeIndex+m_subsetCount);
+					set_tree_subset_color(*it, treeIndex+m_subsetCount);
 
-					ug::MathVector<4> color;
-					get_subset_color(it->color, color);
-					UG_LOGN("it->color: " << it->color);
-					m_s->subset_info(treeIndex+m_subsetCount).color = color;
+					/// the empty subset in front of the trees is erased below
+					if (!it->edges.empty()) {
+						m_treeRoots.push_back(std::make_pair(it->points[it->edges[0].from], static_cast<int>(treeIndex+m_subsetCount-1)));
+					}
 					treeIndex++;
 				}
 
 				m_subsetCount = treeIndex + m_subsetCount;
 				m_subsetCount--;
 
-				RemoveDoubles<3>(*m_g, m_g->vertices_begin(), m_g->vertices_end(), ug::aPosition, REMOVE_DOUBLE_THRESHOLD);
 				EraseEmptySubsets(*m_s);
-
-				if (m_bSomaAvailable) connect_to_soma(trees);
 			}
 
 		private:
-			void process_branches(Tree& t, std::vector<rapidxml::xml_node<>*> branchData, const MathVector<4>& point_before_branch) {
-				std::vector<rapidxml::xml_node<>*>::const_iterator it = branchData.begin();
-				std::vector<CEdge> edges;
-				for (; it != branchData.end(); ++it) {
-					std::vector<MathVector<4> > local_points;
-					rapidxml::xml_node<>* pointData = (*it)->first_node("point");
-					while (pointData) {
-						number x = atof(pointData->first_attribute("x")->value());
-						number y = atof(pointData->first_attribute("y")->value());
-						number z = atof(pointData->first_attribute("z")->value());
-						number d = atof(pointData->first_attribute("d")->value());
-						MathVector<4> point(x, y, z, d);
-						UG_LOGN("x: " << x << ", " << "y: " << y << ", z: " << z << ", d:" << d);
-						t.points.push_back(point);
-						local_points.push_back(point);
-						pointData = pointData->next_sibling("point");
-					}
+			/*!
+			 * \brief creates one vertex per point of the tree in the given subset
+			 */
+			void create_tree_vertices(const Tree& t, int si) {
+				NEUROLUCIDA_LOGN(LOG_ELEMENTS, "#points of tree: " << t.points.size());
+				for (size_t i = 0; i < t.points.size(); i++) {
+					get_vertex(t.points.position(i), t.points.diameter(i), si);
+				}
+			}
 
-					if (local_points.size() >= 1) {
-						CEdge e;
-						e.from = point_before_branch;
-						e.to = local_points[0];
-						edges.push_back(e);
-					}
+			/*!
+			 * \brief creates the edges of the tree in the given subset
+			 */
+			void create_tree_edges(const Tree& t, int si) {
+				std::vector<CEdge>::const_iterator it = t.edges.begin();
+				NEUROLUCIDA_LOGN(LOG_ELEMENTS, "#edges of tree:" << t.edges.size());
+				for (; it != t.edges.end(); ++it) {
+					ug::Vertex* from = get_vertex(t.points.position(it->from), t.points.diameter(it->from), si);
+					ug::Vertex* to = get_vertex(t.points.position(it->to), t.points.diameter(it->to), si);
+					create_edge(from, to, si);
+				}
+			}
 
-					for (size_t i = 0; i < local_points.size()-1; i++) {
-						CEdge e;
-						e.from = local_points[i];
-						e.to = local_points[i+1];
-						edges.push_back(e);
-					}
+			/*!
+			 * \brief names the subset of the tree with the given (1-based) tree index
+			 */
+			void set_tree_subset_name(const Tree& t, int si) {
+				m_s->subset_info(si).name = t.subsetName;
+			}
 
-					// append edges
-					std::vector<CEdge> edges_new;
- 					edges_new.insert(edges_new.end(), t.edges.begin(), t.edges.end());
-					edges_new.insert(edges_new.end(), edges.begin(), edges.end());
-					t.edges.clear();
-					t.edges.insert(t.edges.end(), edges_new.begin(), edges_new.end());
-
-					ug::MathVector<4> point_before_branch_new;
-					if (local_points.size() == 0) {
-						point_before_branch_new = point_before_branch;
-					} else if (local_points.size() == 1) {
-						point_before_branch_new = local_points[0];
-					} else {
-						point_before_branch_new = edges[edges.size()-1].to;
-					}
+			/*!
+			 * \brief name of the subset of the tree
+			 */
+			std::string tree_subset_name(const Tree& t, size_t treeIndex) const {
+				std::stringstream ss;
+				if (!m_bVRLOutputNames) {
+					ss << "Tree" << m_separator << treeIndex << ":" << m_separator << "'" << t.type << "'" << m_separator << "(" << "Leaf:" << m_separator << "'" << t.leaf << "')";
+				} else {
+					std::string str = t.type;
+					str.erase(remove_if(str.begin(), str.end(), isspace), str.end());
+					ss << "Tree" << "_" << treeIndex << "_" << str << "_" << t.leaf;
+				}
+				return ss.str();
+			}
 
-					if ((*it)->first_node("branch")) {
-						UG_LOGN("Branch does contain a branch!");
-						rapidxml::xml_node<>* branchLocal = (*it)->first_node("branch");
-						std::vector<rapidxml::xml_node<>*> branches;
-						while (branchLocal) {
-							branches.push_back(branchLocal);
-							branchLocal = branchLocal->next_sibling("branch");
-						}
-						process_branches(t, branches, point_before_branch_new);
-					} else {
-						UG_LOGN("Branch does not contain a branch!");
-					}
+			/*!
+			 * \brief colors the subset of the tree
+			 */
+			void set_tree_subset_color(const Tree& t, int si) {
+				m_s->subset_info(si).color = t.subsetColor;
+			}
+
+			/*!
+			 * \brief appends a point to the tree and connects it to its parent point
+			 * \param[in] hasParent false for the first point of a tree
+			 * \param[in] parent index of the parent point in Tree::points
+			 * \return index of the new point
+			 */
+			static size_t add_point(Tree& t, const MathVector<4>& point, bool hasParent, size_t parent) {
+				size_t index = t.points.size();
+				t.points.push_back(point);
+				if (hasParent) {
+					CEdge e;
+					e.from = parent;
+					e.to = index;
+					t.edges.push_back(e);
 				}
+				return index;
 			}
 
-			void process_branch(Tree& t, rapidxml::xml_node<>* branchData, const MathVector<4>& point_before_branch) {
-				std::vector<rapidxml::xml_node<>*> branches;
-				if (!branchData) {
-					UG_LOGN("No branches, only points (or recursion end)!");
-					/// TODO this could be wrong! process_branches(t, branches, point_before_branch); assure correctness
-					return;
-				} else {
-					UG_LOGN("Tree has branches!");
-					while (branchData) {
-						branches.push_back(branchData);
-						branchData = branchData->next_sibling("branch");
+			/*!
+			 * \brief processes a branch and all its siblings (depth first)
+			 * Each branch starts at the given parent point, nested branches start at
+			 * the last point of their enclosing branch. Every point and edge is
+			 * created exactly once, thus the topology is built in one linear pass.
+			 * \param[in] branchData first branch node
+			 * \param[in] hasParent false if there is no point to start the branches at
+			 * \param[in] parent index of the point the branches start at
+			 */
+			void process_branches(Tree& t, rapidxml::xml_node<>* branchData, bool hasParent, size_t parent) const {
+				for (; branchData; branchData = branchData->next_sibling("branch")) {
+					bool hasLast = hasParent;
+					size_t last = parent;
+					rapidxml::xml_node<>* pointData = branchData->first_node("point");
+					while (pointData) {
+						MathVector<4> point;
+						DecodePoint(pointData, point);
+						NEUROLUCIDA_LOGN(LOG_ELEMENTS, "x: " << point[0] << ", " << "y: " << point[1] << ", z: " << point[2] << ", d:" << point[3]);
+						last = add_point(t, point, hasLast, last);
+						hasLast = true;
+						pointData = pointData->next_sibling("point");
+					}
+
+					rapidxml::xml_node<>* branchLocal = branchData->first_node("branch");
+					if (branchLocal) {
+						NEUROLUCIDA_LOGN(LOG_ELEMENTS, "Branch does contain a branch!");
+						process_branches(t, branchLocal, hasLast, last);
+					} else {
+						NEUROLUCIDA_LOGN(LOG_ELEMENTS, "Branch does not contain a branch!");
 					}
-					process_branches(t, branches, point_before_branch);
 				}
 			}
 
-
-		protected:
-			void process_contours() {
-				std::vector<Contour> contours;
+			/*!
+			 * \brief reads all contours of the document
+			 */
+			void read_contours(std::vector<Contour>& contours) {
 				rapidxml::xml_node<>* rootNode = m_doc.first_node();
+				size_t numContours = 0;
 
 				if (rootNode) {
-					if (strcmp(rootNode->name(), "mbf") != 0) {
+					if (!has_name(rootNode, "mbf")) {
 						UG_LOG("XML file in wrong format, or no Neurolucida XML file provided!");
 					} else {
 						rapidxml::xml_node<>* contourData = rootNode->first_node("contour");
 						while (contourData) {
 							rapidxml::xml_node<>* pointData = contourData->first_node("point");
 
-							Contour contour;
-							contour.name = contourData->first_attribute("name")->value();
-							contour.closed = strcmp(contourData->first_attribute("closed")->value(), "false") != 0;
-							contour.color = contourData->first_attribute("color")->value();
-							UG_LOGN("Contour name: '" << contour.name << "'");
+							/// the contour is filled in place instead of being copied, reusing a previous one
+							if (numContours == contours.size()) contours.push_back(Contour());
+							Contour& contour = contours[numContours++];
+							contour.clear();
+							contour.name = attribute_string(contourData, "name", "N/A");
+							contour.closed = attribute_string(contourData, "closed", "false") != "false";
+							contour.color = attribute_string(contourData, "color", "");
+							NEUROLUCIDA_LOGN(LOG_ELEMENTS, "Contour name: '" << contour.name << "'");
 
 							while (pointData) {
-						        number x = atof(pointData->first_attribute("x")->value());
-						        number y = atof(pointData->first_attribute("y")->value());
-						        number z = atof(pointData->first_attribute("z")->value());
-						        number d = atof(pointData->first_attribute("d")->value());
-						        MathVector<4> point(x, y, z, d);
-						        UG_LOGN("x: " << x << ", " << "y: " << y << ", z: " << z << ", d: " << d);
+						        MathVector<4> point;
+						        DecodePoint(pointData, point);
+						        NEUROLUCIDA_LOGN(LOG_ELEMENTS, "x: " << point[0] << ", " << "y: " << point[1] << ", z: " << point[2] << ", d: " << point[3]);
 						        contour.points.push_back(point);
 						        pointData = pointData->next_sibling("point");
 
 							}
-							contours.push_back(contour);
 							contourData = contourData->next_sibling("contour");
 						}
 					}
 				} else {
 					UG_LOGN("Error during parsing XML document.")
 				}
+				contours.resize(numContours);
+			}
 
+			/*!
+			 * \brief creates the geometry of all contours from their scaled points
+			 */
+			void create_contours(const std::vector<Contour>& contours) {
 				std::vector<Contour>::const_iterator it = contours.begin();
 				size_t contourIndex = 1;
 				for (; it != contours.end(); ++it) {
@@ -419,87 +724,246 @@ namespace ug {
 						m_bSomaAvailable = true;
 					}
 
-					std::stringstream ss;
-					if (!m_bVRLOutputNames) {
-						ss << "Contour" << m_separator << contourIndex << ":" << m_separator << "'" << it->name << "'" << m_separator << "(Closed:" << m_separator << "'" << std::boolalpha << it->closed << "')";
-					} else {
-						std::string str = it->name;
-						str.erase(remove_if(str.begin(), str.end(), isspace), str.end());
-						ss << "Contour" << "_" << contourIndex << "_" << str << "_" << std::boolalpha << it->closed;
-					}
+					create_contour(*it, contourIndex, contourIndex);
+					contourIndex++;
+				}
 
-					m_s->subset_info(contourIndex).name = ss.str();
-					ug::MathVector<4> color;
-					get_subset_color(it->color, color);
-					m_s->subset_info(contourIndex).color = color;
+				m_subsetCount = contourIndex;
+				m_subsetCount--;
 
-					/// if scaled, it may happen that the first point equals the last point
-					/// in this case if the contour should be non-closed will be closed
-					/// because the next to last point gets connected with the first
-					/// resulting in connectivity
-					size_t no_points = it->points.size();
-					if (!it->closed)
-						no_points--;
+				EraseEmptySubsets(*m_s);
+			}
 
-					for (size_t i = 0; i < no_points-1; i++) {
-						ug::RegularVertex* vtx =  *(m_g->create<ug::RegularVertex>());
-						m_aaPos[vtx] = ug::vector3(m_scaling * it->points[i].coord(0), m_scaling * it->points[i].coord(1), m_scaling * it->points[i].coord(2));
-						m_aaDiameter[vtx] = it->points[i].coord(3) * m_scaling;
-						m_s->assign_subset(vtx, contourIndex);
+			/*!
+			 * \brief number of edges of a contour, the last point of an open contour is not connected
+			 */
+			static size_t num_contour_edges(const Contour& contour) {
+				size_t no_points = contour.points.size();
+				if (!contour.closed && no_points > 0)
+					no_points--;
+				return no_points > 0 ? no_points-1 : 0;
+			}
 
-						ug::RegularVertex* vtx2 =  *(m_g->create<ug::RegularVertex>());
-						m_aaPos[vtx2] = ug::vector3(m_scaling * it->points[i+1].coord(0), m_scaling * it->points[i+1].coord(1), m_scaling * it->points[i+1].coord(2));
-						m_aaDiameter[vtx2] = it->points[i].coord(3) * m_scaling;
+			/*!
+			 * \brief checks if a contour creates any edge, other contours are skipped
+			 */
+			static bool usable_contour(const Contour& contour) {
+				return num_contour_edges(contour) > 0;
+			}
 
-						m_s->assign_subset(vtx, contourIndex);
-						m_s->assign_subset(vtx2, contourIndex);
+			/*!
+			 * \brief checks if a tree has any edge, other trees are skipped
+			 */
+			static bool usable_tree(const Tree& tree) {
+				return !tree.edges.empty();
+			}
 
-						ug::RegularEdge* edge = (*m_g->create<ug::RegularEdge>(EdgeDescriptor(vtx, vtx2)));
-						m_s->assign_subset(edge, contourIndex);
+			/*!
+			 * \brief removes the contours which are skipped, see usable_contour
+			 * Streaming skips the same contours, thus both paths number the subsets equally.
+			 */
+			void remove_unusable_contours(std::vector<Contour>& contours) const {
+				size_t n = 0;
+				for (size_t i = 0; i < contours.size(); i++) {
+					if (!usable_contour(contours[i])) {
+						NEUROLUCIDA_LOGN(LOG_SUMMARY, "Contour '" << contours[i].name << "' has no edges and is skipped.");
+						continue;
+					}
+					if (i != n) std::swap(contours[n], contours[i]);
+					n++;
+				}
+				contours.resize(n);
+			}
 
+			/*!
+			 * \brief removes the trees which are skipped, see usable_tree
+			 */
+			void remove_unusable_trees(std::vector<Tree>& trees) const {
+				size_t n = 0;
+				for (size_t i = 0; i < trees.size(); i++) {
+					if (!usable_tree(trees[i])) {
+						NEUROLUCIDA_LOGN(LOG_SUMMARY, "Tree with type: '" << trees[i].type << "' has no edges and is skipped.");
+						continue;
 					}
-					contourIndex++;
+					if (i != n) std::swap(trees[n], trees[i]);
+					n++;
 				}
+				trees.resize(n);
+			}
 
-				m_subsetCount = contourIndex;
-				m_subsetCount--;
+		private:
+			/*!
+			 * \brief creates the vertices and edges of a contour in the given subset
+			 */
+			void create_contour(const Contour& contour, size_t contourIndex, int si) {
+				m_s->subset_info(si).name = contour_subset_name(contour, contourIndex);
+				ug::MathVector<4> color;
+				get_subset_color(contour.color, color);
+				m_s->subset_info(si).color = color;
+
+				/// if scaled, it may happen that the first point equals the last point
+				/// in this case if the contour should be non-closed will be closed
+				/// because the next to last point gets connected with the first
+				/// resulting in connectivity
+				size_t numEdges = num_contour_edges(contour);
+				for (size_t i = 0; i < numEdges; i++) {
+					/// a new end vertex gets the diameter of the start point (as before)
+					ug::Vertex* vtx = get_vertex(contour.points.position(i), contour.points.diameter(i), si);
+					ug::Vertex* vtx2 = get_vertex(contour.points.position(i+1), contour.points.diameter(i), si);
+					create_edge(vtx, vtx2, si);
+				}
+			}
+
+			/*!
+			 * \brief name of the subset of the contour
+			 */
+			std::string contour_subset_name(const Contour& contour, size_t contourIndex) const {
+				std::stringstream ss;
+				if (!m_bVRLOutputNames) {
+					ss << "Contour" << m_separator << contourIndex << ":" << m_separator << "'" << contour.name << "'" << m_separator << "(Closed:" << m_separator << "'" << std::boolalpha << contour.closed << "')";
+				} else {
+					std::string str = contour.name;
+					str.erase(remove_if(str.begin(), str.end(), isspace), str.end());
+					ss << "Contour" << "_" << contourIndex << "_" << str << "_" << std::boolalpha << contour.closed;
+				}
+				return ss.str();
+			}
+
+		protected:
+			/*!
+			 * \brief connects the root of each tree to the closest soma vertex
+			 */
+			void connect_to_soma() {
+				if (!m_bSomaAvailable) return;
+
+				NEUROLUCIDA_LOGN(LOG_ELEMENTS, "subset count: " << m_subsetCount);
+				NEUROLUCIDA_LOGN(LOG_ELEMENTS, "#trees: " << m_treeRoots.size());
+
+				/// index the soma once for all trees
+				std::vector<ug::Vertex*> vertices;
+				std::vector<ug::vector3> positions;
+				for (ug::VertexIterator it = m_s->begin<ug::Vertex>(m_somaIndex); it != m_s->end<ug::Vertex>(m_somaIndex); ++it) {
+					vertices.push_back(*it);
+					positions.push_back(m_aaPos[*it]);
+				}
+				std::vector<SomaIndex<ug::Vertex*>::Segment> segments;
+				for (ug::EdgeIterator it = m_s->begin<ug::Edge>(m_somaIndex); it != m_s->end<ug::Edge>(m_somaIndex); ++it) {
+					SomaIndex<ug::Vertex*>::Segment segment;
+					segment.from = (*it)->vertex(0);
+					segment.to = (*it)->vertex(1);
+					segment.fromPos = m_aaPos[segment.from];
+					segment.toPos = m_aaPos[segment.to];
+					segments.push_back(segment);
+				}
+				SomaIndex<ug::Vertex*> index;
+				index.build(vertices, positions, segments);
+
+				std::vector<std::pair<MathVector<4>, int> >::const_iterator it = m_treeRoots.begin();
+				for (; it != m_treeRoots.end(); ++it) {
+					connect_root_to_soma(it->first, it->second, index);
+				}
 
-				RemoveDoubles<3>(*m_g, m_g->vertices_begin(), m_g->vertices_end(), ug::aPosition, REMOVE_DOUBLE_THRESHOLD);
 				EraseEmptySubsets(*m_s);
 			}
 
 		private:
-			void connect_to_soma(const std::vector<Tree>& trees) {
-				size_t treeIndex = 1;
-				std::vector<Tree>::const_iterator it = trees.begin();
-				for (; it != trees.end(); ++it) {
-					/// find vertices of edge
-					ug::vector3 temp (m_scaling * it->edges[0].from.coord(0), m_scaling * it->edges[0].from.coord(1), m_scaling * it->edges[0].from.coord(2));
-					ug::Vertex* closest = FindClosestByCoordinate<ug::Vertex>(temp, m_s->begin<ug::Vertex>(m_somaIndex), m_s->end<ug::Vertex>(m_somaIndex), m_aaPos);
-					ug::RegularVertex* vtx =  *(m_g->create<ug::RegularVertex>()); /// RegularVertex* needs to be used in every case, Vertex* cannot be used and will result in faulty code
-					m_aaDiameter[vtx] = it->edges[0].from.coord(3) * m_scaling;
-					m_aaPos[vtx] = temp;
-
-					/// create edge
-					ug::RegularEdge* edge = (*m_g->create<ug::RegularEdge>(EdgeDescriptor(vtx, closest)));
-					UG_LOGN("closest (to soma): " << m_aaPos[closest]);
-					UG_LOGN("temp (from): " << temp);
-					UG_LOGN("subset count: " << m_subsetCount);
-					UG_LOGN("#trees: " << trees.size());
-					m_s->assign_subset(edge, m_subsetCount - trees.size() - 1 + treeIndex);
-					treeIndex++;
+			/*!
+			 * \brief connects the (scaled) root point of a tree to the soma
+			 * Depending on the attachment policy the root is connected to the closest
+			 * soma vertex or to the closest point on a soma edge, which is split there.
+			 * \param[in] root first point of the tree
+			 * \param[in] si subset index of the tree the connecting edge is assigned to
+			 * \param[in] index index of the soma, updated if an edge is split
+			 */
+			void connect_root_to_soma(const MathVector<4>& root, int si, SomaIndex<ug::Vertex*>& index) {
+				/// find vertices of edge
+				ug::vector3 temp (root.coord(0), root.coord(1), root.coord(2));
+				ug::Vertex* closest = NULL;
+				size_t segment;
+				ug::vector3 closestPos;
+				number t;
+				if (m_somaAttachment == SOMA_ATTACH_EDGE && index.closest_segment(temp, segment, closestPos, t)) {
+					/// only the ends of the soma edge are reused, any other vertex there (e.g. the root) splits it
+					if (!index.segment_end(segment, closestPos, REMOVE_DOUBLE_THRESHOLD, closest)) {
+						/// split the soma edge at the attachment point, at the root itself if it lies on the edge
+						SomaIndex<ug::Vertex*>::Segment s = index.segment(segment);
+						number diameter = (1 - t) * m_aaDiameter[s.from] + t * m_aaDiameter[s.to];
+						closest = get_vertex(closestPos, diameter, m_somaIndex);
+						ug::Edge* edge = m_g->get_edge(s.from, s.to);
+						if (edge) m_g->erase(edge);
+						create_edge(s.from, closest, m_somaIndex);
+						create_edge(closest, s.to, m_somaIndex);
+						index.split_segment(segment, closest, m_aaPos[closest]);
+					}
+				} else {
+					index.closest_vertex(temp, closest);
 				}
+				if (!closest) return;
+				ug::Vertex* vtx = get_vertex(temp, root.coord(3), -1);
 
-				RemoveDoubles<3>(*m_g, m_g->vertices_begin(), m_g->vertices_end(), ug::aPosition, REMOVE_DOUBLE_THRESHOLD);
-				EraseEmptySubsets(*m_s);
+				/// create edge
+				create_edge(vtx, closest, si);
+				NEUROLUCIDA_LOGN(LOG_ELEMENTS, "closest (to soma): " << m_aaPos[closest]);
+				NEUROLUCIDA_LOGN(LOG_ELEMENTS, "temp (from): " << temp);
+			}
+
+			/*!
+			 * \brief returns the vertex at the (scaled) position
+			 * A new vertex is only created if there is no vertex closer than
+			 * REMOVE_DOUBLE_THRESHOLD yet, hence no RemoveDoubles pass is needed.
+			 * \param[in] diameter scaled diameter of a new vertex
+			 * \param[in] si subset of a new vertex, -1 for none
+			 */
+			ug::Vertex* get_vertex(const ug::vector3& pos, number diameter, int si) {
+				m_statistics.add(Statistics::COUNTER_VERTICES_REQUESTED, 1);
+				ug::Vertex* existing = m_vertexHash.find(pos);
+				if (existing) return existing;
+
+				ug::RegularVertex* vtx = *(m_g->create<ug::RegularVertex>()); /// RegularVertex* needs to be used in every case, Vertex* cannot be used and will result in faulty code
+				m_aaPos[vtx] = pos;
+				m_aaDiameter[vtx] = diameter;
+				if (si >= 0) m_s->assign_subset(vtx, si);
+				m_vertexHash.insert(vtx, pos);
+				m_statistics.add(Statistics::COUNTER_VERTICES, 1);
+				return vtx;
+			}
+
+			/*!
+			 * \brief creates an edge unless it already exists or would be degenerated
+			 */
+			void create_edge(ug::Vertex* vtx, ug::Vertex* vtx2, int si) {
+				if (vtx == vtx2 || m_g->get_edge(vtx, vtx2)) return;
+				ug::RegularEdge* edge = (*m_g->create<ug::RegularEdge>(EdgeDescriptor(vtx, vtx2)));
+				m_s->assign_subset(edge, si);
+				m_statistics.add(Statistics::COUNTER_EDGES, 1);
 			}
 
 		public:
+			inline ug::Grid& grid() {
+				return *m_g;
+			}
+
+			inline ug::SubsetHandler& subset_handler() {
+				return *m_s;
+			}
+
 			void print_setup() const {
 				std::cout << "Neurolucida conversion settings:" << std::endl;
 				std::cout << "\tScaling: '" << m_scaling << "'" << std::endl;
 				std::cout << "\tSeparator: '" << m_separator << "'" << std::endl;
 				std::cout << "\tVRL Output Names: '" << std::boolalpha << m_bVRLOutputNames << "'" << std::endl;
+				std::cout << "\tStreaming: '" << std::boolalpha << m_bStreaming << "'" << std::endl;
+				std::cout << "\tMemory mapped: '" << std::boolalpha << m_bMemoryMapped << "'" << std::endl;
+				std::cout << "\tStreaming output: '" << std::boolalpha << m_bStreamingOutput << "'" << std::endl;
+				std::cout << "\tLog level: '" << m_logLevel << "'" << std::endl;
+				std::cout << "\tSoma attachment: '" << (m_somaAttachment == SOMA_ATTACH_EDGE ? "edge" : "vertex") << "'" << std::endl;
+				std::cout << "\tCache directory: '" << m_cacheDirectory << "'" << std::endl;
+				std::cout << "\tThreads: '" << m_numThreads << "'" << std::endl;
+				std::cout << "\tSimplification tolerances: '" << m_simplifyPositionTolerance << "', '" << m_simplifyDiameterTolerance << "'" << std::endl;
+				std::cout << "\tCompression: '" << (m_compression == COMPRESSION_NONE ? "none" : CompressionExtension(m_compression)) << "'" << std::endl;
+				std::cout << "\tMorphometrics: '" << (m_morphometricsFormat == MORPHOMETRICS_JSON ? "json" : m_morphometricsFormat == MORPHOMETRICS_CSV ? "csv" : "none") << "', Sholl step: '" << m_morphometrics.get_sholl_step() << "'" << std::endl;
+				std::cout << "\tStatistics output: '" << std::boolalpha << m_bStatisticsOutput << "'" << std::endl;
+				std::cout << "\tSurface output: '" << (m_surfaceFormat == SURFACE_UGX ? "ugx" : m_surfaceFormat == SURFACE_OBJ ? "obj" : "none") << "', resolution: '" << m_surfaceResolution << "'" << std::endl;
 				std::cout << "\tREMOVE_DOUBLES_TRESHOLD: '" << REMOVE_DOUBLE_THRESHOLD << "'" << std::endl;
 				std::cout << std::endl;
 			}
@@ -512,29 +976,303 @@ namespace ug {
 				return m_bVRLOutputNames;
 			}
 
-			inline void set_scaling(number scaling) {
-				m_scaling = scaling;
+			/*!
+			 * \brief enables or disables the streaming reader
+			 * If enabled contours and trees are converted while the file is read,
+			 * thus memory for parsing is bounded by the largest tree instead of the
+			 * file size. Only elements which are direct children of the document
+			 * respectively of trees and branches are considered (as for the DOM reader).
+			 */
+			inline void set_streaming(bool streaming) {
+				m_bStreaming = streaming;
 			}
 
-			inline number get_scaling() const {
-				return m_scaling;
+			inline bool get_streaming() const {
+				return m_bStreaming;
 			}
 
-			inline void set_separator(const std::string& separator) {
-				m_separator = separator;
+			/*!
+			 * \brief enables or disables writing UGX output without a grid
+			 * If enabled, vertices and edges are written to the UGX file as soon as a
+			 * contour or tree has been processed. Only the diameters, the subsets
+			 * as index ranges, a hash of the vertex positions and the set of written
+			 * edges are kept, instead of the grid and the DOM of the serializer.
+			 * Combined with the streaming reader memory is linear in the number of
+			 * vertices and edges, but much smaller than for the grid.
+			 * A grid is still created if OBJ output is requested as well.
+			 */
+			inline void set_streaming_output(bool streamingOutput) {
+				m_bStreamingOutput = streamingOutput;
 			}
 
-			inline std::string get_separator() const {
-				return m_separator;
+			inline bool get_streaming_output() const {
+				return m_bStreamingOutput;
 			}
 
-			inline void set_convert_to_obj(bool objOutput) {
-				m_bConvertToOBJ = objOutput;
-
+			/*!
+			 * \brief enables or disables memory mapped input
+			 * If enabled the file is mapped read-only and parsed non-destructively,
+			 * i.e. names and values of the DOM point directly into the mapping. The
+			 * mapping and the DOM are kept, so converting the same unchanged file
+			 * again (e.g. to another output format) does not read and parse it again.
+			 * Note that entities (&amp; etc.) in attribute values are not translated.
+			 */
+			inline void set_memory_mapped(bool memoryMapped) {
+				m_bMemoryMapped = memoryMapped;
+				if (!m_bMemoryMapped) release_input();
 			}
 
-			inline void set_convert_to_ugx(bool ugxOutput) {
-				m_bConvertToUGX = ugxOutput;
+			inline bool get_memory_mapped() const {
+				return m_bMemoryMapped;
+			}
+
+			/*!
+			 * \brief sets the directory of the binary morphology cache
+			 * Parsed contours and trees are stored there, keyed by a hash of the file
+			 * content, so converting the same file again loads the cache instead of
+			 * parsing the XML. The cache is not used by the streaming reader.
+			 * \param[in] cacheDirectory existing directory, empty to disable the cache (default)
+			 */
+			inline void set_cache_directory(const std::string& cacheDirectory) {
+				m_cacheDirectory = cacheDirectory;
+			}
+
+			inline const std::string& get_cache_directory() const {
+				return m_cacheDirectory;
+			}
+
+			/*!
+			 * \brief enables the simplification of trees before the grid is created
+			 * Oversampled branches are thinned out by a Douglas-Peucker algorithm:
+			 * inner points of a branch are removed as long as the positions and the
+			 * diameters of all removed points deviate from the linear interpolation
+			 * between the remaining points by no more than the tolerances. Branch
+			 * points, tree roots (which are attached to the soma) and leaves are
+			 * always kept. Branches are simplified in parallel, see set_num_threads.
+			 * The SWC output is written from the original points.
+			 * \param[in] positionTolerance in the units of the file (usually micrometer)
+			 * \param[in] diameterTolerance in the units of the file (usually micrometer)
+			 * Setting both tolerances to 0 disables the simplification.
+			 */
+			inline void set_simplification(number positionTolerance, number diameterTolerance) {
+				UG_COND_THROW(positionTolerance < 0 || diameterTolerance < 0, "Simplification tolerances must not be negative.");
+				m_simplifyPositionTolerance = positionTolerance;
+				m_simplifyDiameterTolerance = diameterTolerance;
+			}
+
+			/*!
+			 * \brief number of tree points removed by the simplification of the last document
+			 */
+			inline size_t get_num_simplified_points() const {
+				return m_numSimplifiedPoints;
+			}
+
+			/*!
+			 * \brief sets the compression of the output files
+			 * Output files get the extension of the compression appended, e.g.
+			 * ".ugx.gz", and are compressed on a separate thread while written.
+			 * \param[in] compression one of Compression (0 none, 1 gzip, 2 zstd)
+			 */
+			inline void set_compression(int compression) {
+				UG_COND_THROW(!CompressionAvailable(compression), "Compression '" << compression << "' is not available in this build.");
+				m_compression = compression;
+			}
+
+			inline int get_compression() const {
+				return m_compression;
+			}
+
+			/*!
+			 * \brief enables the morphometrics summary of each converted file
+			 * Total length, surface area (lateral area of the frustums between
+			 * consecutive points), volume, branches and length per branch order and
+			 * the Sholl profile are computed from the parsed trees in the units of
+			 * the file, before simplification and scaling. The summary is written to
+			 * the output name with '.morphometrics.csv' or '.morphometrics.json'
+			 * appended. If it is the only output enabled, no grid is created at all.
+			 * \param[in] format one of MorphometricsFormat (0 none, 1 CSV, 2 JSON)
+			 */
+			inline void set_morphometrics_output(int format) {
+				UG_COND_THROW(format < MORPHOMETRICS_NONE || format > MORPHOMETRICS_JSON, "Unknown morphometrics format '" << format << "'.");
+				m_morphometricsFormat = format;
+			}
+
+			inline int get_morphometrics_output() const {
+				return m_morphometricsFormat;
+			}
+
+			/*!
+			 * \brief sets the distance of the Sholl spheres in the units of the file
+			 * The spheres are centered at the centroid of the soma contour, or at the
+			 * root of the first tree if there is no soma. 0 disables the Sholl profile.
+			 */
+			inline void set_sholl_step(number shollStep) {
+				m_morphometrics.set_sholl_step(shollStep);
+			}
+
+			inline number get_sholl_step() const {
+				return m_morphometrics.get_sholl_step();
+			}
+
+			/*!
+			 * \brief morphometrics of the last converted file, see set_morphometrics_output
+			 */
+			inline const Morphometrics& get_morphometrics() const {
+				return m_morphometrics;
+			}
+
+			inline number get_total_length() const {
+				return m_morphometrics.total_length();
+			}
+
+			inline number get_surface_area() const {
+				return m_morphometrics.surface_area();
+			}
+
+			inline number get_volume() const {
+				return m_morphometrics.volume();
+			}
+
+			/*!
+			 * \brief enables writing the statistics of each converted file as JSON
+			 * The statistics are written to the output name with '.statistics.json'
+			 * appended, see get_statistics.
+			 */
+			inline void set_statistics_output(bool statisticsOutput) {
+				m_bStatisticsOutput = statisticsOutput;
+			}
+
+			inline bool get_statistics_output() const {
+				return m_bStatisticsOutput;
+			}
+
+			/*!
+			 * \brief wall-clock time per phase and counts of the last converted file
+			 * Phases are reading, parsing, tree processing, grid creation (merging
+			 * double vertices while they are created), soma attachment and output.
+			 * Vertices and edges are counted for the grid, or for the UGX output if it
+			 * is streamed without a grid.
+			 */
+			inline const Statistics& get_statistics() const {
+				return m_statistics;
+			}
+
+			/*!
+			 * \brief prints the statistics of the last converted file
+			 */
+			inline void print_statistics() const {
+				m_statistics.print();
+			}
+
+			/*!
+			 * \brief releases the memory mapped input and its DOM
+			 */
+			void release_input() {
+				m_doc.clear();
+				m_mappedFile.close();
+			}
+
+			/*!
+			 * \brief resets the instance to convert the next file, the settings are kept
+			 * Removes the geometry, subsets and DOM of the previous conversion, which
+			 * convert does as well. Memory is kept for the next file: the blocks of the
+			 * DOM (in a process wide pool, see neurolucida_block_pool.h), the buffers of
+			 * the parsed points and edges, and the attachment data of the grid.
+			 */
+			void reset() {
+				clear_document();
+				release_input();
+				m_statistics.clear();
+				m_cacheKey = CacheKey();
+				std::vector<Contour>::iterator contourIt = m_contours.begin();
+				for (; contourIt != m_contours.end(); ++contourIt) {
+					contourIt->clear();
+				}
+				std::vector<Tree>::iterator treeIt = m_trees.begin();
+				for (; treeIt != m_trees.end(); ++treeIt) {
+					treeIt->clear();
+				}
+			}
+
+			/*!
+			 * \brief sets the verbosity of the conversion
+			 * \param[in] logLevel 0: errors only, 1: summary per document (default), 2: every element
+			 */
+			inline void set_log_level(int logLevel) {
+				m_logLevel = logLevel;
+			}
+
+			inline int get_log_level() const {
+				return m_logLevel;
+			}
+
+			/*!
+			 * \brief sets the number of threads trees are read and prepared with
+			 * Trees are decoded, scaled and named in parallel, the elements of the
+			 * grid are then created serially in the order of the trees. Hence the
+			 * output does not depend on the number of threads.
+			 * \param[in] numThreads 1: serial (default), 0: all hardware threads
+			 */
+			inline void set_num_threads(size_t numThreads) {
+				if (numThreads != m_numThreads) m_threadPool.reset();
+				m_numThreads = numThreads;
+			}
+
+			inline size_t get_num_threads() const {
+				return m_numThreads;
+			}
+
+			/*!
+			 * \brief sets where trees are attached to the soma
+			 * \param[in] somaAttachment 0: closest soma vertex (default), 1: closest point on a soma edge
+			 */
+			inline void set_soma_attachment(int somaAttachment) {
+				m_somaAttachment = somaAttachment;
+			}
+
+			inline int get_soma_attachment() const {
+				return m_somaAttachment;
+			}
+
+			inline void set_scaling(number scaling) {
+				m_scaling = scaling;
+			}
+
+			inline number get_scaling() const {
+				return m_scaling;
+			}
+
+			inline void set_separator(const std::string& separator) {
+				m_separator = separator;
+			}
+
+			inline std::string get_separator() const {
+				return m_separator;
+			}
+
+			inline void set_convert_to_obj(bool objOutput) {
+				m_bConvertToOBJ = objOutput;
+
+			}
+
+			inline void set_convert_to_ugx(bool ugxOutput) {
+				m_bConvertToUGX = ugxOutput;
+			}
+
+			/*!
+			 * \brief enables or disables SWC output
+			 * SWC is written directly from the parsed contours and trees in
+			 * micrometers (unscaled). The soma contour ('Cell Body') is written as a
+			 * chain of soma samples and each tree root is attached to the closest soma
+			 * sample, other contours are omitted. If SWC is the only output enabled,
+			 * no grid is created at all.
+			 */
+			inline void set_convert_to_swc(bool swcOutput) {
+				m_bConvertToSWC = swcOutput;
+			}
+
+			inline bool get_convert_to_swc() const {
+				return m_bConvertToSWC;
 			}
 
 			inline bool get_convert_to_obj() const {
@@ -545,6 +1283,49 @@ namespace ug {
 				return m_bConvertToUGX;
 			}
 
+			/*!
+			 * \brief adds an output format written from the grid
+			 * The sink is given the finished grid together with UGX and OBJ output,
+			 * the file name is the output name with the extension of the sink.
+			 */
+			inline void add_output_sink(SmartPtr<OutputSink> sink) {
+				m_outputSinks.push_back(sink);
+			}
+
+			inline void clear_output_sinks() {
+				m_outputSinks.clear();
+			}
+
+			/*!
+			 * \brief enables the tube surface mesh around the edges of the grid
+			 * Each point gets a ring of vertices with its diameter, oriented by
+			 * parallel transport frames, tips are capped and branches are joined by
+			 * spheres, see CreateTubeSurface. The rings are created in parallel, see
+			 * set_num_threads. The mesh is written to the output name with
+			 * '.surface.obj' or '.surface.ugx' appended.
+			 * \param[in] format one of SurfaceFormat (0 none, 1 OBJ, 2 UGX)
+			 */
+			inline void set_surface_output(int format) {
+				UG_COND_THROW(format < SURFACE_NONE || format > SURFACE_UGX, "Unknown surface format '" << format << "'.");
+				m_surfaceFormat = format;
+			}
+
+			inline int get_surface_output() const {
+				return m_surfaceFormat;
+			}
+
+			/*!
+			 * \brief sets the number of vertices per ring of the tube surface, at least 3
+			 */
+			inline void set_surface_resolution(size_t numRingVertices) {
+				UG_COND_THROW(numRingVertices < 3, "A ring of the surface needs at least 3 vertices.");
+				m_surfaceResolution = numRingVertices;
+			}
+
+			inline size_t get_surface_resolution() const {
+				return m_surfaceResolution;
+			}
+
 			inline void convert(const std::string& filename, bool outputUGX, bool outputOBJ) {
 				set_output_name(filename);
 				set_convert_to_ugx(outputUGX);
@@ -559,7 +1340,279 @@ namespace ug {
 				parse_file(filename);
 			}
 
+			/*!
+			 * \brief converts a file without writing any output
+			 * The grid and subset handler (with the diameter attachment) are available
+			 * via grid() and subset_handler() afterwards and may be written by save_grid.
+			 * All outputs, including output sinks and statistics, are disabled during
+			 * the conversion and restored afterwards.
+			 */
+			void convert_in_memory(const std::string& filename);
+
+			/*!
+			 * \brief converts a file into a new domain without writing any output
+			 */
+			SmartPtr<Domain3d> convert_to_domain(const std::string& filename);
+
+			/*!
+			 * \brief copies vertices, edges, subsets and diameters of the grid into the domain
+			 */
+			void copy_to_domain(Domain3d& dom);
+
+			/*!
+			 * \brief writes the grid, the format is given by the extension of the file name
+			 */
+			inline void save_grid(const std::string& filename) {
+				UG_COND_THROW(!SaveGridToFile(*m_g, *m_s, filename.c_str()), "Could not write file '" << filename << "'.");
+			}
+
+			/*!
+			 * \brief converts many files in parallel
+			 * Every file is converted by its own Neurolucida instance (with its own
+			 * grid and subset handler) using the settings of this instance. If neither
+			 * UGX, OBJ nor SWC output is enabled, UGX output is written as for convert(filename).
+			 * \param[in] filenames files to convert
+			 * \param[in] numThreads number of threads, 0 uses all hardware threads
+			 * \return number of successfully converted files
+			 */
+			size_t convert_batch(const std::vector<std::string>& filenames, size_t numThreads);
+
+			/*!
+			 * \brief converts all .xml files of a directory or all files listed in a text file
+			 * \param[in] listOrDirectory directory or text file with one file name per line
+			 * \param[in] numThreads number of threads, 0 uses all hardware threads
+			 * \return number of successfully converted files
+			 */
+			size_t convert_batch(const std::string& listOrDirectory, size_t numThreads);
+
+			/*!
+			 * \brief prints success, failure and timing of each file of the last batch
+			 */
+			void print_batch_report() const;
+
+			/*!
+			 * \brief converts many files distributed across the processes of a parallel run
+			 * Must be called by all processes with the same files. Files are handed out
+			 * dynamically: whenever a process has finished a file it requests the next one
+			 * not yet taken from process 0, which only hands out files if there are several
+			 * processes. Each process writes the outputs of its files, as configured
+			 * for convert_batch, and process 0 gathers the results of all files for the
+			 * batch report. Without UG_PARALLEL the files are converted by convert_batch
+			 * on a single thread. Locally testable with e.g. 'mpirun -np 4 ugshell ...'.
+			 * \return number of successfully converted files of all processes (on all processes)
+			 */
+			size_t convert_distributed(const std::vector<std::string>& filenames);
+
+			/*!
+			 * \brief distributed conversion of the files of a directory or file list, see convert_batch
+			 */
+			size_t convert_distributed(const std::string& listOrDirectory);
+
+			/*!
+			 * \brief adds a cell to the network
+			 * \param[in] transform placement of the cell, applied to the points in the
+			 * units of the file: 3 values (translation), 12 values (3x4 affine matrix,
+			 * row-major, translation in the last column) or 16 values (4x4 homogeneous
+			 * matrix, row-major). Diameters are scaled by the cube root of the determinant.
+			 */
+			void add_network_cell(const std::string& filename, const std::vector<number>& transform);
+
+			inline void add_network_cell(const std::string& filename) {
+				add_network_cell(filename, std::vector<number>());
+			}
+
+			/*!
+			 * \brief adds the cells listed in a text file to the network
+			 * One cell per line: the file name followed by 0, 3, 12 or 16 numbers of the
+			 * transform (see add_network_cell). Empty lines and lines starting with '#'
+			 * are ignored, relative file names are relative to the working directory.
+			 */
+			void read_network(const std::string& networkFile);
+
+			inline void clear_network() {
+				m_networkCells.clear();
+				m_bNetworkAssembled = false;
+			}
+
+			inline size_t num_network_cells() const {
+				return m_networkCells.size();
+			}
+
+			/*!
+			 * \brief converts all cells of the network into the grid
+			 * Cells are converted in parallel, each by its own instance with the settings
+			 * of this instance, and appended to the grid in the order they were added,
+			 * thus the grid does not depend on the number of threads. Each cell keeps its
+			 * own subsets, named 'Cell<i>_' followed by the subset name of the cell.
+			 * \param[in] numThreads number of threads, 0 uses all hardware threads
+			 */
+			void assemble_network(size_t numThreads);
+
+			/*!
+			 * \brief assigns the vertices and edges of the grid to partitions
+			 * The partitions are stored in a second subset handler, subset p holding
+			 * the elements of partition (i.e. process) p. Partitioning by cells requires
+			 * the grid of assemble_network, which is discarded when a file is converted.
+			 * \param[in] partitioning one of NetworkPartitioning
+			 * \param[in] numPartitions number of partitions, e.g. processes of the parallel run
+			 */
+			void compute_partitions(int partitioning, size_t numPartitions);
+
+			/*!
+			 * \brief writes the grid as UGX with the subset handlers "defSH" and, if
+			 * computed, "partitions"
+			 */
+			void save_network(const std::string& filename);
+
+			/*!
+			 * \brief reads, assembles, partitions and writes a network
+			 * \param[in] networkFile cells and transforms, see read_network
+			 * \param[in] outputFile UGX file written
+			 */
+			void convert_network(const std::string& networkFile, const std::string& outputFile,
+								 int partitioning, size_t numPartitions, size_t numThreads);
+
+			/*!
+			 * \brief copies the partitions into a subset handler of a domain filled by copy_to_domain
+			 * Elements are matched in the order they were created, thus the domain must
+			 * not contain other elements. The subset handler may be the partition handler
+			 * of a PartitionMap assigned to the grid of the domain, which can then be
+			 * used to distribute the domain without partitioning it again.
+			 */
+			void copy_partitions(Domain3d& dom, ug::ISubsetHandler& partitions);
+
+			/*!
+			 * \brief finds candidate synapses between the cells of the assembled network
+			 * Axonal segments are tested against the dendritic (basal and apical)
+			 * segments of all other cells, the kind of a segment is given by the
+			 * tree type in the name of its subset. A pair is reported if the distance
+			 * of the frustum surfaces, with radii interpolated at the closest points
+			 * of the center lines, is at most the threshold. Works for millions of
+			 * segments: the dendritic segments are stored in a spatial hash and the
+			 * axonal segments query it in parallel.
+			 * \param[in] threshold distance in the units of the grid (scaled)
+			 * \param[in] numThreads number of threads, 0 uses all hardware threads
+			 * \return number of appositions found
+			 */
+			size_t find_appositions(number threshold, size_t numThreads);
+
+			/*!
+			 * \brief writes the appositions found last as CSV
+			 * Each line holds the (1-based) cell and the subset name of the axonal and
+			 * the dendritic segment, the position and the distance of the apposition.
+			 * The file is compressed according to its extension, e.g. '.csv.gz'.
+			 */
+			void write_appositions(const std::string& filename) const;
+
+			inline const std::vector<Apposition>& get_appositions() const {
+				return m_appositions;
+			}
+
+			inline size_t get_num_appositions() const {
+				return m_appositions.size();
+			}
+
 		private:
+			/*!
+			 * \brief takes over the conversion settings (not the state) of another instance
+			 * The output sinks are shared, thus it must not run concurrently, see create_converter.
+			 */
+			void copy_settings(const Neurolucida& other) {
+				m_bConvertToUGX = other.m_bConvertToUGX;
+				m_bConvertToOBJ = other.m_bConvertToOBJ;
+				m_bConvertToSWC = other.m_bConvertToSWC;
+				m_bVRLOutputNames = other.m_bVRLOutputNames;
+				m_bStreaming = other.m_bStreaming;
+				m_bMemoryMapped = other.m_bMemoryMapped;
+				m_bStreamingOutput = other.m_bStreamingOutput;
+				m_logLevel = other.m_logLevel;
+				m_somaAttachment = other.m_somaAttachment;
+				m_numThreads = other.m_numThreads;
+				m_compression = other.m_compression;
+				m_simplifyPositionTolerance = other.m_simplifyPositionTolerance;
+				m_simplifyDiameterTolerance = other.m_simplifyDiameterTolerance;
+				m_morphometricsFormat = other.m_morphometricsFormat;
+				m_bStatisticsOutput = other.m_bStatisticsOutput;
+				m_outputSinks = other.m_outputSinks;
+				m_surfaceFormat = other.m_surfaceFormat;
+				m_surfaceResolution = other.m_surfaceResolution;
+				m_morphometrics.set_sholl_step(other.m_morphometrics.get_sholl_step());
+				m_separator = other.m_separator;
+				m_scaling = other.m_scaling;
+				m_cacheDirectory = other.m_cacheDirectory;
+			}
+
+			/*!
+			 * \brief collects the .xml files of a directory, a single .xml file or the files of a list
+			 */
+			static void collect_batch_files(const std::string& listOrDirectory, std::vector<std::string>& filenames);
+
+			/*!
+			 * \brief creates a converter with the settings of this instance for one thread
+			 * Instances are created and destroyed under a lock, since their setup
+			 * accesses global ug4 state.
+			 */
+			Neurolucida* create_converter() const;
+
+			/*!
+			 * \brief destroys a converter created by create_converter
+			 */
+			static void destroy_converter(Neurolucida* converter);
+
+			/*!
+			 * \brief cell of a network
+			 */
+			struct NetworkCell {
+				std::string filename;
+				number transform[12]; ///<! 3x4 affine matrix, row-major
+				int firstSubset; ///<! subsets of the cell in the network grid
+				int numSubsets;
+				size_t numVertices;
+			};
+
+			std::vector<NetworkCell> m_networkCells;
+			bool m_bNetworkAssembled; ///<! the grid is the network of m_networkCells, see assemble_network
+			std::unique_ptr<ug::SubsetHandler> m_partitions; ///<! partitions of the network, if computed
+			std::vector<Apposition> m_appositions; ///<! of the network, if computed
+
+			/*!
+			 * \brief appends the grid of a converted cell to the grid
+			 */
+			void append_cell(Neurolucida& cell, NetworkCell& networkCell, size_t cellIndex);
+
+			/*!
+			 * \brief converters of a batch waiting for their next file
+			 */
+			struct IdleConverters {
+				std::mutex mutex;
+				std::vector<Neurolucida*> converters;
+			};
+
+			/*!
+			 * \brief converts one file of a batch, called on a worker thread
+			 * An idle converter is reused if available, thus at most one converter
+			 * per worker is created and its memory is reused for the next files.
+			 */
+			void convert_batch_file(BatchResult& result, IdleConverters& idle) const;
+
+			/*!
+			 * \brief checks the name of a node
+			 * Names are not zero terminated if the DOM was parsed non-destructively
+			 */
+			static bool has_name(const rapidxml::xml_node<>* node, const char* name) {
+				return node->name_size() == strlen(name) && strncmp(node->name(), name, node->name_size()) == 0;
+			}
+
+			/*!
+			 * \brief returns the value of the attribute with the given name
+			 * \param[in] defaultValue returned if the attribute is missing, as when streaming
+			 */
+			static std::string attribute_string(const rapidxml::xml_node<>* node, const char* name, const char* defaultValue) {
+				const rapidxml::xml_attribute<>* attribute = node->first_attribute(name);
+				if (!attribute) return defaultValue;
+				return std::string(attribute->value(), attribute->value_size());
+			}
+
 			/*
 			 * \brief returns RGBA color for ProMesh
 			 *  Note: A (opacity) not used for now,
@@ -567,7 +1620,7 @@ namespace ug {
 			 * 		  into the range [0,1] from a RGBA color
 			 * 		  in hex or dec in the range of [0, FF] respectively [0,255]
 			 */
-			void get_subset_color(const std::string& colorString, ug::MathVector<4>& color) {
+			void get_subset_color(const std::string& colorString, ug::MathVector<4>& color) const {
 				 size_t firstChar = colorString.find_first_of("#");
 				 /*
 				  * if color information from Neurolucida is erroneous:
@@ -588,43 +1641,350 @@ namespace ug {
 				 color.coord(3) = 1.f;
 			}
 
+			/*!
+			 * \brief converts the file, see parse_document, and collects the statistics
+			 */
+			void parse_file(const std::string& filename);
+
+			/*!
+			 * \brief converts the file by the configured input mode and writes the outputs
+			 */
+			void parse_document(const std::string& filename);
+
+			/*!
+			 * \brief writes the statistics of the current document as JSON
+			 */
+			void write_statistics();
+
+		protected:
 			/*!
 			 * sets the outputname based on the input file name
 			 */
 			void set_output_name(const std::string& inputFileName) {
-				 size_t lastdot = inputFileName.find_last_of(".");
+				 std::string fileName = StripCompressionExtension(inputFileName);
+				 size_t lastdot = fileName.find_last_of(".");
 	  		     std::string name;
 			     std::string ext;
 			     std::stringstream ss;
-			     if (lastdot == std::string::npos) name = inputFileName;
-			     name = inputFileName.substr(0, lastdot);
+			     if (lastdot == std::string::npos) name = fileName;
+			     name = fileName.substr(0, lastdot);
 			     m_outputName = name;
+			     m_inputName = inputFileName;
 			}
 
 			inline std::string get_output_name() const {
 				return m_outputName;
 			}
 
-			void parse_file(const std::string& filename);
+			/*!
+			 * \brief reads the file into a zero terminated buffer owned by the DOM
+			 */
+			char* read_file(const std::string& filename);
+
+			/*!
+			 * \brief parses a read-only mapping of the file non-destructively
+			 * \return false if the file cannot be mapped without a copy
+			 */
+			bool parse_file_mapped(const std::string& filename);
+
+			/*!
+			 * \brief parses a zero terminated buffer, e.g. from read_file, into the DOM
+			 */
+			void parse_buffer(char* content) {
+				Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_PARSE);
+				m_doc.parse<0>(content);
+			}
+
+			/*!
+			 * \brief forgets vertices and tree roots of a previous document
+			 */
+			void begin_document() {
+				m_vertexHash.clear();
+				m_treeRoots.clear();
+				m_numSimplifiedPoints = 0;
+			}
+
+			/*!
+			 * \brief removes the geometry and subsets of a previous document
+			 * The attachments of the grid and the memory of its attachment data are kept.
+			 */
+			void clear_document() {
+				m_partitions.reset();
+				m_appositions.clear();
+				m_bNetworkAssembled = false;
+				m_s->clear();
+				m_g->clear_geometry();
+				m_subsetCount = 0;
+				m_somaIndex = 0;
+				m_bSomaAvailable = false;
+				m_streamedSoma = StreamedSoma();
+				begin_document();
+			}
+
+		private:
+			/*!
+			 * \brief reads the file with the XMLStreamReader and builds the
+			 * geometry of each contour and tree as soon as it has been read
+			 */
+			void parse_file_streaming(const std::string& filename);
+
+		protected:
+			/*!
+			 * \brief writes the grid to the requested output formats
+			 * The grid is traversed once and all formats are written concurrently.
+			 */
+			void save_output();
+
+			/*!
+			 * \brief collects vertices, edges and subsets of the grid for the output sinks
+			 */
+			void collect_output_geometry(OutputGeometry& geometry);
+
+			/*!
+			 * \brief name of an output file including the extension of the compression
+			 */
+			inline std::string output_file_name(const std::string& extension) const {
+				return m_outputName + extension + CompressionExtension(m_compression);
+			}
+
+			/*!
+			 * \brief checks if the grid has to be created
+			 * This is the case for OBJ output, for UGX output unless it is streamed,
+			 * for surface output, for additional output sinks and for conversions
+			 * without any output, which keep the grid in memory.
+			 */
+			inline bool needs_grid() const {
+				return m_bConvertToOBJ || (m_bConvertToUGX && !m_bStreamingOutput)
+					|| m_surfaceFormat != SURFACE_NONE || !m_outputSinks.empty()
+					|| (!m_bConvertToUGX && !m_bConvertToSWC && !writes_morphometrics());
+			}
+
+			/*!
+			 * \brief checks if the morphometrics summary is written
+			 */
+			inline bool writes_morphometrics() const {
+				return m_morphometricsFormat != MORPHOMETRICS_NONE;
+			}
+
+			/*!
+			 * \brief checks if UGX output is written without the grid
+			 */
+			inline bool streams_ugx() const {
+				return m_bConvertToUGX && m_bStreamingOutput;
+			}
+
+			/*!
+			 * \brief output settings saved while converting in memory
+			 */
+			struct OutputSettings {
+				bool convertToUGX;
+				bool convertToOBJ;
+				bool convertToSWC;
+				bool statisticsOutput;
+				int morphometricsFormat;
+				int surfaceFormat;
+				std::vector<SmartPtr<OutputSink> > outputSinks;
+			};
+
+			/*!
+			 * \brief saves the output settings and disables all outputs
+			 * The sinks are moved instead of copied, see copy_settings.
+			 */
+			void disable_output(OutputSettings& settings) {
+				settings.convertToUGX = m_bConvertToUGX;
+				settings.convertToOBJ = m_bConvertToOBJ;
+				settings.convertToSWC = m_bConvertToSWC;
+				settings.statisticsOutput = m_bStatisticsOutput;
+				settings.morphometricsFormat = m_morphometricsFormat;
+				settings.surfaceFormat = m_surfaceFormat;
+				settings.outputSinks.swap(m_outputSinks);
+
+				m_bConvertToUGX = false;
+				m_bConvertToOBJ = false;
+				m_bConvertToSWC = false;
+				m_bStatisticsOutput = false;
+				m_morphometricsFormat = MORPHOMETRICS_NONE;
+				m_surfaceFormat = SURFACE_NONE;
+				m_outputSinks.clear();
+			}
+
+			/*!
+			 * \brief restores the output settings saved by disable_output
+			 */
+			void restore_output(OutputSettings& settings) {
+				m_bConvertToUGX = settings.convertToUGX;
+				m_bConvertToOBJ = settings.convertToOBJ;
+				m_bConvertToSWC = settings.convertToSWC;
+				m_bStatisticsOutput = settings.statisticsOutput;
+				m_morphometricsFormat = settings.morphometricsFormat;
+				m_surfaceFormat = settings.surfaceFormat;
+				m_outputSinks.swap(settings.outputSinks);
+			}
+
+		private:
+			/*!
+			 * \brief opens the SWC output of the current document
+			 */
+			void open_swc();
+
+			/*!
+			 * \brief completes the SWC output of the current document
+			 */
+			void close_swc();
+
+			/*!
+			 * \brief writes the soma contour as soma samples, other contours are not part of SWC
+			 */
+			void write_swc_contour(const Contour& contour);
+
+			/*!
+			 * \brief writes the samples of a tree in the order of its points
+			 * Points are created after their parent point, hence every parent is
+			 * written before its children. The root is attached to the closest soma sample.
+			 */
+			void write_swc_tree(const Tree& t);
+
+			/*!
+			 * \brief completes the morphometrics of the current document and writes the summary
+			 */
+			void write_morphometrics();
+
+			/*!
+			 * \brief opens the UGX output written without a grid
+			 */
+			void open_ugx_stream();
+
+			/*!
+			 * \brief writes a contour with scaled points to the UGX output
+			 */
+			void stream_contour(const Contour& contour, size_t contourIndex, int si);
+
+			/*!
+			 * \brief writes a prepared tree to the UGX output
+			 */
+			void stream_tree(const Tree& t, int si);
+
+			/*!
+			 * \brief connects the tree roots to the soma and completes the UGX output
+			 */
+			void close_ugx_stream();
+
+			/*!
+			 * \brief determines the cache entry of the given file
+			 * \return false if the content of the file cannot be read
+			 */
+			bool find_cache_key(const std::string& filename, CacheKey& key) const;
+
+			/*!
+			 * \brief loads the contours and trees of the cache entry
+			 * \return false if there is no valid cache file for the entry
+			 */
+			bool load_cache(const CacheKey& key, std::vector<Contour>& contours, std::vector<Tree>& trees) const;
+
+			/*!
+			 * \brief stores the contours and trees as cache entry
+			 */
+			void write_cache(const CacheKey& key, const std::vector<Contour>& contours, const std::vector<Tree>& trees) const;
 
 			void process_document() {
-				/// process contours and trees
-				process_contours();
-				process_trees();
+				/// read contours and trees
+				{
+					Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_PARSE);
+					read_contours(m_contours);
+					read_trees(m_trees);
+				}
 
-				/// save grid to obj if demanded
-				if (m_bConvertToOBJ) {
-					std::stringstream ss;
-					ss << m_outputName << OBJ_EXTENSION;
-					SaveGridToFile(*m_g, *m_s, ss.str().c_str());
+				if (!m_cacheKey.file.empty()) {
+					Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+					write_cache(m_cacheKey, m_contours, m_trees);
+					m_statistics.add(Statistics::COUNTER_BYTES_WRITTEN, FileSize(m_cacheKey.file));
 				}
 
-				/// save grid to ugx if demanded
-				if (m_bConvertToUGX) {
-					std::stringstream ss;
-					ss << m_outputName << UGX_EXTENSION;
-					SaveGridToFile(*m_g, *m_s, ss.str().c_str());
+				build_document(m_contours, m_trees);
+			}
+
+			/*!
+			 * \brief writes SWC and creates the geometry, the points are scaled in place
+			 */
+			void build_document(std::vector<Contour>& contours, std::vector<Tree>& trees) {
+				begin_document();
+				for (size_t i = 0; i < contours.size(); i++) {
+					m_statistics.add(Statistics::COUNTER_POINTS, contours[i].points.size());
+				}
+				for (size_t i = 0; i < trees.size(); i++) {
+					m_statistics.add(Statistics::COUNTER_POINTS, trees[i].points.size());
+					m_statistics.add(Statistics::COUNTER_TREE_EDGES, trees[i].edges.size());
+				}
+				remove_unusable_contours(contours);
+				remove_unusable_trees(trees);
+
+				/// SWC is written from the parsed topology, without the grid
+				if (m_bConvertToSWC) {
+					Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+					open_swc();
+					std::vector<Contour>::const_iterator contourIt = contours.begin();
+					for (; contourIt != contours.end(); ++contourIt) {
+						write_swc_contour(*contourIt);
+					}
+					std::vector<Tree>::const_iterator treeIt = trees.begin();
+					for (; treeIt != trees.end(); ++treeIt) {
+						write_swc_tree(*treeIt);
+					}
+					close_swc();
+				}
+
+				/// morphometrics are computed from the parsed points, without the grid
+				if (writes_morphometrics()) {
+					Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+					m_morphometrics.clear();
+					std::vector<Contour>::const_iterator contourIt = contours.begin();
+					for (; contourIt != contours.end(); ++contourIt) {
+						if (contourIt->name == "Cell Body") m_morphometrics.add_soma(contourIt->points);
+					}
+					std::vector<Tree>::const_iterator treeIt = trees.begin();
+					for (; treeIt != trees.end(); ++treeIt) {
+						m_morphometrics.add_tree(treeIt->points, treeIt->edges);
+					}
+					write_morphometrics();
+				}
+
+				if (!needs_grid() && !streams_ugx()) return;
+
+				{
+					Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_TREES);
+					scale_points(contours);
+					prepare_trees(trees);
+				}
+
+				/// UGX is written without the grid, subsets are numbered consecutively
+				if (streams_ugx()) {
+					Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_OUTPUT);
+					open_ugx_stream();
+					int si = 0;
+					for (size_t i = 0; i < contours.size(); i++) {
+						stream_contour(contours[i], i+1, si++);
+					}
+					for (size_t i = 0; i < trees.size(); i++) {
+						stream_tree(trees[i], si++);
+					}
+					close_ugx_stream();
+					m_statistics.set(Statistics::COUNTER_SUBSETS, si);
+				}
+
+				if (!needs_grid()) return;
+
+				/// process contours and trees
+				{
+					Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_GRID);
+					create_contours(contours);
+					create_trees(trees);
+				}
+				{
+					Statistics::ScopedPhase phase(m_statistics, Statistics::PHASE_SOMA);
+					connect_to_soma();
 				}
+				m_statistics.set(Statistics::COUNTER_SUBSETS, m_s->num_subsets());
+				save_output();
 			}
 		};
 	}
@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_apposition.cpp
+ * \brief detection of appositions between axonal and dendritic segments
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida.h"
+#include "neurolucida_apposition.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	/*!
+	 * \brief axis aligned bounding box
+	 */
+	struct Box {
+		ug::vector3 min;
+		ug::vector3 max;
+	};
+
+	/*!
+	 * \brief bounding box of the frustum of the segment, enlarged by the margin
+	 */
+	Box BoxOfSegment(const AppositionSegment& segment, number margin) {
+		number r = std::max(segment.radiusFrom, segment.radiusTo) + margin;
+		Box box;
+		for (size_t i = 0; i < 3; i++) {
+			box.min[i] = std::min(segment.from[i], segment.to[i]) - r;
+			box.max[i] = std::max(segment.from[i], segment.to[i]) + r;
+		}
+		return box;
+	}
+
+	inline bool Overlap(const Box& a, const Box& b) {
+		return a.min[0] <= b.max[0] && b.min[0] <= a.max[0]
+			&& a.min[1] <= b.max[1] && b.min[1] <= a.max[1]
+			&& a.min[2] <= b.max[2] && b.min[2] <= a.max[2];
+	}
+
+	/*!
+	 * \brief uniform grid over the boxes of the dendritic segments
+	 * Grid cells are hashed into buckets, the segments of a bucket are stored
+	 * consecutively. A segment is stored once per bucket, even if several of its
+	 * cells share the bucket, thus each pair is found at most once in the
+	 * reference cell of the pair. Other cells sharing a bucket only cause
+	 * additional box tests.
+	 */
+	class SegmentHash {
+	public:
+		void build(const std::vector<Box>& boxes) {
+			m_bounds.min = ug::vector3(numeric_limits<number>::max(), numeric_limits<number>::max(), numeric_limits<number>::max());
+			m_bounds.max = ug::vector3(-numeric_limits<number>::max(), -numeric_limits<number>::max(), -numeric_limits<number>::max());
+			number extent = 0;
+			for (size_t i = 0; i < boxes.size(); i++) {
+				for (size_t d = 0; d < 3; d++) {
+					m_bounds.min[d] = std::min(m_bounds.min[d], boxes[i].min[d]);
+					m_bounds.max[d] = std::max(m_bounds.max[d], boxes[i].max[d]);
+				}
+				extent += std::max(boxes[i].max[0] - boxes[i].min[0],
+						  std::max(boxes[i].max[1] - boxes[i].min[1], boxes[i].max[2] - boxes[i].min[2]));
+			}
+
+			/// cells as large as the average box, thus a box is stored in few cells
+			m_cellSize = boxes.empty() ? 0 : extent / boxes.size();
+			if (!(m_cellSize > 0)) m_cellSize = 1;
+			for (size_t d = 0; d < 3; d++) {
+				m_maxCell[d] = boxes.empty() ? 0 : static_cast<int64_t>(std::floor((m_bounds.max[d] - m_bounds.min[d]) / m_cellSize));
+			}
+
+			/// count the cells of all boxes (an upper bound of the entries), then store the segments by bucket
+			size_t numEntries = 0;
+			for (size_t i = 0; i < boxes.size(); i++) {
+				int64_t lo[3], hi[3];
+				cell_range(boxes[i], lo, hi);
+				numEntries += (hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1);
+			}
+			size_t numBuckets = 1;
+			while (numBuckets < numEntries) numBuckets *= 2;
+			m_mask = numBuckets - 1;
+
+			/// segments are added in order, thus a segment already in a bucket is its last one
+			std::vector<size_t> last(numBuckets, numeric_limits<size_t>::max());
+			m_offsets.assign(numBuckets + 1, 0);
+			for (size_t i = 0; i < boxes.size(); i++) {
+				for_each_cell(boxes[i], [this, i, &last](const int64_t c[3]) {
+					const size_t b = bucket(c);
+					if (last[b] == i) return;
+					last[b] = i;
+					m_offsets[b + 1]++;
+				});
+			}
+			for (size_t b = 0; b < numBuckets; b++) {
+				m_offsets[b + 1] += m_offsets[b];
+			}
+			m_segments.resize(m_offsets[numBuckets]);
+			std::vector<size_t> next(m_offsets.begin(), m_offsets.end() - 1);
+			for (size_t i = 0; i < boxes.size(); i++) {
+				for_each_cell(boxes[i], [this, i, &next](const int64_t c[3]) {
+					const size_t b = bucket(c);
+					if (next[b] > m_offsets[b] && m_segments[next[b] - 1] == i) return;
+					m_segments[next[b]++] = i;
+				});
+			}
+		}
+
+		inline const Box& bounds() const {
+			return m_bounds;
+		}
+
+		/*!
+		 * \brief cell of the point, clamped to the grid
+		 */
+		inline void cell(const ug::vector3& p, int64_t c[3]) const {
+			for (size_t d = 0; d < 3; d++) {
+				number x = std::floor((p[d] - m_bounds.min[d]) / m_cellSize);
+				x = std::max(number(0), std::min(x, static_cast<number>(m_maxCell[d])));
+				c[d] = static_cast<int64_t>(x);
+			}
+		}
+
+		inline void cell_range(const Box& box, int64_t lo[3], int64_t hi[3]) const {
+			cell(box.min, lo);
+			cell(box.max, hi);
+		}
+
+		template <typename TFunction>
+		void for_each_cell(const Box& box, TFunction f) const {
+			int64_t lo[3], hi[3], c[3];
+			cell_range(box, lo, hi);
+			for (c[0] = lo[0]; c[0] <= hi[0]; c[0]++) {
+				for (c[1] = lo[1]; c[1] <= hi[1]; c[1]++) {
+					for (c[2] = lo[2]; c[2] <= hi[2]; c[2]++) {
+						f(c);
+					}
+				}
+			}
+		}
+
+		inline size_t bucket(const int64_t c[3]) const {
+			uint64_t h = static_cast<uint64_t>(c[0]) * 0x9E3779B97F4A7C15ULL
+					   ^ static_cast<uint64_t>(c[1]) * 0xC2B2AE3D27D4EB4FULL
+					   ^ static_cast<uint64_t>(c[2]) * 0x165667B19E3779F9ULL;
+			h ^= h >> 32;
+			return static_cast<size_t>(h & m_mask);
+		}
+
+		inline const size_t* begin(size_t bucket) const {
+			return m_segments.empty() ? NULL : &m_segments[0] + m_offsets[bucket];
+		}
+
+		inline const size_t* end(size_t bucket) const {
+			return m_segments.empty() ? NULL : &m_segments[0] + m_offsets[bucket + 1];
+		}
+
+	private:
+		Box m_bounds;
+		number m_cellSize;
+		int64_t m_maxCell[3];
+		uint64_t m_mask;
+		std::vector<size_t> m_offsets; ///<! first entry of each bucket
+		std::vector<size_t> m_segments; ///<! segments of all buckets
+	};
+
+	bool AppositionLess(const Apposition& a, const Apposition& b) {
+		return a.axonSegment < b.axonSegment || (a.axonSegment == b.axonSegment && a.dendriteSegment < b.dendriteSegment);
+	}
+
+	/// axonal segments queried by one task
+	const size_t APPOSITION_CHUNK_SIZE = 1024;
+}
+
+number ug::neurolucida::ClosestPointsOfSegments(const ug::vector3& p1, const ug::vector3& q1, const ug::vector3& p2,
+												const ug::vector3& q2, number& s, number& t) {
+	ug::vector3 d1, d2, r;
+	VecSubtract(d1, q1, p1);
+	VecSubtract(d2, q2, p2);
+	VecSubtract(r, p1, p2);
+	number a = VecDot(d1, d1);
+	number e = VecDot(d2, d2);
+	number f = VecDot(d2, r);
+
+	if (a <= 0 && e <= 0) {
+		s = t = 0;
+	} else if (a <= 0) {
+		s = 0;
+		t = std::min(number(1), std::max(number(0), f / e));
+	} else {
+		number c = VecDot(d1, r);
+		if (e <= 0) {
+			t = 0;
+			s = std::min(number(1), std::max(number(0), -c / a));
+		} else {
+			/// closest points of the lines, clamped to the segments
+			number b = VecDot(d1, d2);
+			number denom = a * e - b * b;
+			s = denom > 0 ? std::min(number(1), std::max(number(0), (b * f - c * e) / denom)) : 0;
+			t = (b * s + f) / e;
+			if (t < 0) {
+				t = 0;
+				s = std::min(number(1), std::max(number(0), -c / a));
+			} else if (t > 1) {
+				t = 1;
+				s = std::min(number(1), std::max(number(0), (b - c) / a));
+			}
+		}
+	}
+
+	ug::vector3 c1, c2;
+	VecScaleAdd(c1, 1, p1, s, d1);
+	VecScaleAdd(c2, 1, p2, t, d2);
+	return VecDistance(c1, c2);
+}
+
+void ug::neurolucida::FindAppositions(ThreadPool& pool, const std::vector<AppositionSegment>& axons,
+									  const std::vector<AppositionSegment>& dendrites, number threshold,
+									  std::vector<Apposition>& appositions) {
+	appositions.clear();
+	if (axons.empty() || dendrites.empty()) return;
+
+	/// dendritic boxes are enlarged by the threshold, hence overlapping boxes are necessary for an apposition
+	std::vector<Box> dendriteBoxes(dendrites.size());
+	for (size_t i = 0; i < dendrites.size(); i++) {
+		dendriteBoxes[i] = BoxOfSegment(dendrites[i], threshold);
+	}
+	SegmentHash hash;
+	hash.build(dendriteBoxes);
+
+	const size_t numChunks = (axons.size() + APPOSITION_CHUNK_SIZE - 1) / APPOSITION_CHUNK_SIZE;
+	std::vector<std::vector<Apposition> > found(numChunks);
+	ParallelFor(pool, numChunks, [&](size_t chunk) {
+		std::vector<Apposition>& result = found[chunk];
+		const size_t last = std::min(axons.size(), (chunk + 1) * APPOSITION_CHUNK_SIZE);
+		for (size_t i = chunk * APPOSITION_CHUNK_SIZE; i < last; i++) {
+			const AppositionSegment& axon = axons[i];
+			Box box = BoxOfSegment(axon, 0);
+			if (!Overlap(box, hash.bounds())) continue;
+
+			hash.for_each_cell(box, [&](const int64_t c[3]) {
+				const size_t bucket = hash.bucket(c);
+				for (const size_t* it = hash.begin(bucket); it != hash.end(bucket); ++it) {
+					const size_t j = *it;
+					const AppositionSegment& dendrite = dendrites[j];
+					const Box& dendriteBox = dendriteBoxes[j];
+					if (axon.cell == dendrite.cell || !Overlap(box, dendriteBox)) continue;
+
+					/// the pair is tested in the cell of the minimum corner of the intersection only
+					ug::vector3 corner;
+					int64_t ref[3];
+					for (size_t d = 0; d < 3; d++) {
+						corner[d] = std::max(box.min[d], dendriteBox.min[d]);
+					}
+					hash.cell(corner, ref);
+					if (ref[0] != c[0] || ref[1] != c[1] || ref[2] != c[2]) continue;
+
+					number s, t;
+					number centerDistance = ClosestPointsOfSegments(axon.from, axon.to, dendrite.from, dendrite.to, s, t);
+					number radius = (1 - s) * axon.radiusFrom + s * axon.radiusTo
+								  + (1 - t) * dendrite.radiusFrom + t * dendrite.radiusTo;
+					number distance = centerDistance - radius;
+					if (distance > threshold) continue;
+
+					Apposition apposition;
+					apposition.axonSegment = i;
+					apposition.dendriteSegment = j;
+					apposition.axonCell = axon.cell;
+					apposition.dendriteCell = dendrite.cell;
+					apposition.axonSubset = axon.subset;
+					apposition.dendriteSubset = dendrite.subset;
+					ug::vector3 onAxon, onDendrite;
+					VecScaleAdd(onAxon, 1 - s, axon.from, s, axon.to);
+					VecScaleAdd(onDendrite, 1 - t, dendrite.from, t, dendrite.to);
+					VecScaleAdd(apposition.position, 0.5, onAxon, 0.5, onDendrite);
+					apposition.distance = distance;
+					result.push_back(apposition);
+				}
+			});
+		}
+		std::sort(result.begin(), result.end(), AppositionLess);
+	});
+
+	/// chunks are ordered by their axonal segments
+	for (size_t chunk = 0; chunk < numChunks; chunk++) {
+		appositions.insert(appositions.end(), found[chunk].begin(), found[chunk].end());
+	}
+}
+
+size_t Neurolucida::find_appositions(number threshold, size_t numThreads) {
+	UG_COND_THROW(!m_bNetworkAssembled, "Appositions require an assembled network.");
+	UG_COND_THROW(threshold < 0, "The apposition threshold has to be non-negative.");
+
+	/// cell and kind of each subset of the network
+	const int numSubsets = m_s->num_subsets();
+	std::vector<size_t> cellOfSubset(numSubsets, 0);
+	std::vector<int> typeOfSubset(numSubsets, SWC_UNDEFINED);
+	for (size_t c = 0; c < m_networkCells.size(); c++) {
+		const NetworkCell& cell = m_networkCells[c];
+		for (int si = cell.firstSubset; si < cell.firstSubset + cell.numSubsets && si < numSubsets; si++) {
+			cellOfSubset[si] = c;
+		}
+	}
+	for (int si = 0; si < numSubsets; si++) {
+		typeOfSubset[si] = SwcTypeOfTree(m_s->subset_info(si).name);
+	}
+
+	std::vector<AppositionSegment> axons;
+	std::vector<AppositionSegment> dendrites;
+	for (ug::EdgeIterator it = m_g->begin<ug::Edge>(); it != m_g->end<ug::Edge>(); ++it) {
+		int si = m_s->get_subset_index(*it);
+		if (si < 0) continue;
+		int type = typeOfSubset[si];
+		if (type != SWC_AXON && type != SWC_BASAL_DENDRITE && type != SWC_APICAL_DENDRITE) continue;
+
+		AppositionSegment segment;
+		segment.from = m_aaPos[(*it)->vertex(0)];
+		segment.to = m_aaPos[(*it)->vertex(1)];
+		segment.radiusFrom = number(0.5) * m_aaDiameter[(*it)->vertex(0)];
+		segment.radiusTo = number(0.5) * m_aaDiameter[(*it)->vertex(1)];
+		segment.cell = cellOfSubset[si];
+		segment.subset = si;
+		if (type == SWC_AXON) {
+			axons.push_back(segment);
+		} else {
+			dendrites.push_back(segment);
+		}
+	}
+
+	ThreadPool pool(numThreads);
+	FindAppositions(pool, axons, dendrites, threshold, m_appositions);
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "found " << m_appositions.size() << " appositions of " << axons.size()
+					 << " axonal and " << dendrites.size() << " dendritic segments");
+	return m_appositions.size();
+}
+
+void Neurolucida::write_appositions(const std::string& filename) const {
+	OutputFile out;
+	UG_COND_THROW(!out.open(filename, CompressionOfFile(filename)), "Could not open file '" << filename << "'.");
+	out.precision(numeric_limits<double>::digits10 + 2);
+	out << "axon_cell,axon_subset,dendrite_cell,dendrite_subset,x,y,z,distance\n";
+	std::vector<Apposition>::const_iterator it = m_appositions.begin();
+	for (; it != m_appositions.end(); ++it) {
+		out << it->axonCell + 1 << "," << m_s->subset_info(it->axonSubset).name << ","
+			<< it->dendriteCell + 1 << "," << m_s->subset_info(it->dendriteSubset).name << ","
+			<< it->position[0] << "," << it->position[1] << "," << it->position[2] << "," << it->distance << "\n";
+	}
+	UG_COND_THROW(!out.close(), "Could not write file '" << filename << "'.");
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "written " << m_appositions.size() << " appositions to file '" << filename << "'");
+}
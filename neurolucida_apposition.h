@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_apposition.h
+ * \brief detection of appositions between axonal and dendritic segments
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_APPOSITION__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_APPOSITION__
+
+#include <vector>
+
+#include <common/math/ugmath.h>
+
+#include "neurolucida_thread_pool.h"
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief frustum between two points of a cell
+		 */
+		struct AppositionSegment {
+			ug::vector3 from;
+			ug::vector3 to;
+			number radiusFrom;
+			number radiusTo;
+			size_t cell; ///<! segments of the same cell are never in apposition
+			int subset;
+		};
+
+		/*!
+		 * \brief candidate contact of an axonal and a dendritic segment
+		 */
+		struct Apposition {
+			size_t axonSegment;
+			size_t dendriteSegment;
+			size_t axonCell;
+			size_t dendriteCell;
+			int axonSubset;
+			int dendriteSubset;
+			ug::vector3 position; ///<! midpoint of the closest points of the center lines
+			number distance; ///<! distance of the surfaces, negative if they overlap
+		};
+
+		/*!
+		 * \brief closest points of the segments [p1, q1] and [p2, q2]
+		 * \param[out] s parameter of the closest point on the first segment in [0, 1]
+		 * \param[out] t parameter of the closest point on the second segment in [0, 1]
+		 * \return distance of the closest points
+		 */
+		number ClosestPointsOfSegments(const ug::vector3& p1, const ug::vector3& q1, const ug::vector3& p2,
+									   const ug::vector3& q2, number& s, number& t);
+
+		/*!
+		 * \brief finds all pairs of axonal and dendritic segments of different cells
+		 * whose surfaces are closer than the threshold
+		 * The dendritic segments are stored in a uniform spatial hash, the grid
+		 * cells of which are about as large as the segments. Each axonal segment
+		 * queries the cells its bounding box overlaps, in parallel on the pool.
+		 * A pair is only tested in the grid cell containing the minimum corner of
+		 * the intersection of both bounding boxes, thus every pair is reported once.
+		 * \param[out] appositions ordered by axonal and then dendritic segment
+		 */
+		void FindAppositions(ThreadPool& pool, const std::vector<AppositionSegment>& axons,
+							 const std::vector<AppositionSegment>& dendrites, number threshold,
+							 std::vector<Apposition>& appositions);
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_APPOSITION__
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_batch.cpp
+ * \brief parallel conversion of many files
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida.h"
+#include "neurolucida_thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+#include "common/util/file_util.h"
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	/// serializes access to global ug4 state (global attachments) during setup of instances
+	std::mutex globalStateMutex;
+
+	/// compressed files (e.g. ".xml.gz") are recognized by the extension in front of the compression
+	bool has_xml_extension(const string& filename) {
+		string name = StripCompressionExtension(filename);
+		size_t lastdot = name.find_last_of(".");
+		if (lastdot == string::npos) return false;
+		string ext = name.substr(lastdot);
+		transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		return ext == ".xml";
+	}
+}
+
+size_t Neurolucida::convert_batch(const string& listOrDirectory, size_t numThreads) {
+	vector<string> filenames;
+	collect_batch_files(listOrDirectory, filenames);
+	return convert_batch(filenames, numThreads);
+}
+
+void Neurolucida::collect_batch_files(const std::string& listOrDirectory, std::vector<std::string>& filenames) {
+	if (DirectoryExists(listOrDirectory.c_str())) {
+		vector<string> files;
+		UG_COND_THROW(!GetFilesInDirectory(files, listOrDirectory.c_str()),
+					  "Could not read directory '" << listOrDirectory << "'.");
+		sort(files.begin(), files.end());
+		for (vector<string>::const_iterator it = files.begin(); it != files.end(); ++it) {
+			if (has_xml_extension(*it)) filenames.push_back(listOrDirectory + "/" + *it);
+		}
+	} else if (has_xml_extension(listOrDirectory)) {
+		filenames.push_back(listOrDirectory);
+	} else {
+		ifstream in(listOrDirectory.c_str());
+		UG_COND_THROW(!in, "Could not open file list '" << listOrDirectory << "'.");
+		string line;
+		while (getline(in, line)) {
+			line.erase(line.find_last_not_of(" \t\r\n") + 1);
+			line.erase(0, line.find_first_not_of(" \t"));
+			if (!line.empty() && line[0] != '#') filenames.push_back(line);
+		}
+	}
+}
+
+size_t Neurolucida::convert_batch(const vector<string>& filenames, size_t numThreads) {
+	m_batchResults.clear();
+	m_batchResults.resize(filenames.size());
+	for (size_t i = 0; i < filenames.size(); i++) {
+		m_batchResults[i].filename = filenames[i];
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	IdleConverters idle;
+	{
+		ThreadPool pool(numThreads);
+		NEUROLUCIDA_LOGN(LOG_SUMMARY, "Converting " << filenames.size() << " files with " << pool.num_threads() << " threads.");
+		for (size_t i = 0; i < m_batchResults.size(); i++) {
+			BatchResult* result = &m_batchResults[i];
+			pool.submit([this, result, &idle]() { convert_batch_file(*result, idle); });
+		}
+		pool.wait();
+	}
+
+	for (size_t i = 0; i < idle.converters.size(); i++) {
+		destroy_converter(idle.converters[i]);
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	size_t numSuccess = 0;
+	for (size_t i = 0; i < m_batchResults.size(); i++) {
+		if (m_batchResults[i].success) numSuccess++;
+	}
+
+	if (m_logLevel >= LOG_SUMMARY) print_batch_report();
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "Converted " << numSuccess << " of " << m_batchResults.size() << " files in " << seconds << " s.");
+	return numSuccess;
+}
+
+Neurolucida* Neurolucida::create_converter() const {
+	/// copying the settings copies the shared output sinks, whose reference counts are not atomic
+	lock_guard<std::mutex> lock(globalStateMutex);
+	Neurolucida* converter = new Neurolucida();
+	converter->copy_settings(*this);
+	/// files are already converted in parallel
+	converter->m_numThreads = 1;
+	/// UG_LOG is not thread safe, thus only the calling thread reports, see print_batch_report
+	converter->m_logLevel = LOG_SILENT;
+	return converter;
+}
+
+void Neurolucida::destroy_converter(Neurolucida* converter) {
+	lock_guard<std::mutex> lock(globalStateMutex);
+	delete converter;
+}
+
+void Neurolucida::convert_batch_file(BatchResult& result, IdleConverters& idle) const {
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	try {
+		Neurolucida* converter = NULL;
+		{
+			lock_guard<std::mutex> lock(idle.mutex);
+			if (!idle.converters.empty()) {
+				converter = idle.converters.back();
+				idle.converters.pop_back();
+			}
+		}
+
+		if (!converter) {
+			converter = create_converter();
+			/// without any output UGX is written, a morphometrics-only batch writes no grid
+			if (!converter->m_bConvertToUGX && !converter->m_bConvertToOBJ && !converter->m_bConvertToSWC
+				&& !converter->writes_morphometrics()) {
+				converter->m_bConvertToUGX = true;
+			}
+		}
+
+		try {
+			converter->set_output_name(result.filename);
+			converter->parse_file(result.filename);
+			result.points = converter->get_statistics().counter(Statistics::COUNTER_POINTS);
+			result.bytesWritten = converter->get_statistics().counter(Statistics::COUNTER_BYTES_WRITTEN);
+			converter->reset();
+		} catch (...) {
+			/// a failed conversion may leave the converter in any state, thus it is not reused
+			destroy_converter(converter);
+			throw;
+		}
+
+		{
+			lock_guard<std::mutex> lock(idle.mutex);
+			idle.converters.push_back(converter);
+		}
+		result.success = true;
+	} catch (const UGError& err) {
+		result.message = err.get_msg();
+	} catch (const std::exception& e) {
+		result.message = e.what();
+	} catch (...) {
+		result.message = "unknown error";
+	}
+	result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void Neurolucida::print_batch_report() const {
+	UG_LOGN("Batch conversion report:");
+	for (vector<BatchResult>::const_iterator it = m_batchResults.begin(); it != m_batchResults.end(); ++it) {
+		stringstream ss;
+		ss << fixed << setprecision(3) << it->seconds;
+		UG_LOG("\t" << (it->success ? "OK    " : "FAILED") << "\t" << ss.str() << " s\t" << it->filename);
+		if (it->success) UG_LOG("\t(" << it->points << " points, " << it->bytesWritten << " bytes written)");
+		if (!it->success) UG_LOG("\t(" << it->message << ")");
+		UG_LOGN("");
+	}
+}
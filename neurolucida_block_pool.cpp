@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_block_pool.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_block_pool.h"
+
+#include <map>
+#include <mutex>
+#include <new>
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	/*!
+	 * \brief precedes each block, padded to keep the block maximally aligned
+	 */
+	union BlockHeader {
+		size_t capacity;
+		long double alignLongDouble;
+		void* alignPointer;
+	};
+
+	/// free blocks by capacity
+	typedef multimap<size_t, BlockHeader*> FreeBlocks;
+
+	mutex blockPoolMutex;
+	FreeBlocks freeBlocks;
+	size_t freeBytes = 0;
+	size_t poolCapacity = size_t(256) << 20;
+
+	/// a free block is only reused for requests of at least half its capacity
+	inline bool fits(size_t capacity, size_t size) {
+		return capacity / 2 <= size;
+	}
+}
+
+void* ug::neurolucida::BlockPoolAllocate(std::size_t size) {
+	{
+		lock_guard<mutex> lock(blockPoolMutex);
+		FreeBlocks::iterator it = freeBlocks.lower_bound(size);
+		if (it != freeBlocks.end() && fits(it->first, size)) {
+			BlockHeader* header = it->second;
+			freeBytes -= it->first;
+			freeBlocks.erase(it);
+			return header + 1;
+		}
+	}
+
+	BlockHeader* header = static_cast<BlockHeader*>(::operator new(sizeof(BlockHeader) + size));
+	header->capacity = size;
+	return header + 1;
+}
+
+void ug::neurolucida::BlockPoolFree(void* block) {
+	if (!block) return;
+	BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+	{
+		lock_guard<mutex> lock(blockPoolMutex);
+		if (freeBytes + header->capacity <= poolCapacity) {
+			freeBytes += header->capacity;
+			freeBlocks.insert(make_pair(header->capacity, header));
+			return;
+		}
+	}
+	::operator delete(header);
+}
+
+void ug::neurolucida::SetBlockPoolCapacity(std::size_t bytes) {
+	lock_guard<mutex> lock(blockPoolMutex);
+	poolCapacity = bytes;
+	/// the largest blocks are freed first
+	while (freeBytes > poolCapacity) {
+		FreeBlocks::iterator it = --freeBlocks.end();
+		freeBytes -= it->first;
+		::operator delete(it->second);
+		freeBlocks.erase(it);
+	}
+}
+
+void ug::neurolucida::ReleaseBlockPool() {
+	lock_guard<mutex> lock(blockPoolMutex);
+	for (FreeBlocks::iterator it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+		::operator delete(it->second);
+	}
+	freeBlocks.clear();
+	freeBytes = 0;
+}
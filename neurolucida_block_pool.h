@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_block_pool.h
+ * \brief recycles the memory blocks of DOMs across documents
+ *
+ * rapidxml frees the blocks of its memory pool when a document is cleared.
+ * If BlockPoolAllocate and BlockPoolFree are set as the allocator of the
+ * document, freed blocks are kept in a process wide pool instead and handed
+ * out again when the next document is parsed, e.g. by a converter instance
+ * reused for many files.
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_BLOCK_POOL__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_BLOCK_POOL__
+
+#include <cstddef>
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief returns a block of at least the given size, a recycled one if available
+		 * Throws std::bad_alloc if no memory is available.
+		 */
+		void* BlockPoolAllocate(std::size_t size);
+
+		/*!
+		 * \brief returns a block obtained from BlockPoolAllocate to the pool
+		 * Blocks exceeding the capacity of the pool are freed.
+		 */
+		void BlockPoolFree(void* block);
+
+		/*!
+		 * \brief sets the maximum number of bytes kept in the pool (default 256 MiB)
+		 */
+		void SetBlockPoolCapacity(std::size_t bytes);
+
+		/*!
+		 * \brief frees all blocks kept in the pool
+		 */
+		void ReleaseBlockPool();
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_BLOCK_POOL__
@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_cache.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+using namespace ug::neurolucida;
+using namespace std;
+
+/*
+ * Layout of a cache file (native byte order, all sections 8 byte aligned):
+ *
+ *   CacheHeader
+ *   ContourRecord[numContours]
+ *   TreeRecord[numTrees]
+ *   scalar x[numPoints], y[numPoints], z[numPoints], d[numPoints] (padded)
+ *   uint32_t from[numEdges], to[numEdges] (padded)
+ *   char strings[stringBytes] (zero terminated strings, padded)
+ *
+ * Points of all contours and trees are stored consecutively, edges refer to
+ * the points of their tree and strings are given as offsets into the strings.
+ * The scalar type is the one points are stored with, thus points are copied
+ * into their stores without any conversion.
+ */
+namespace {
+	/// increase whenever the layout or the interpretation of the XML changes
+	const uint32_t CACHE_VERSION = 3;
+	const char CACHE_MAGIC[8] = {'N', 'L', 'C', 'A', 'C', 'H', 'E', '\0'};
+	const uint32_t CACHE_BYTE_ORDER = 0x01020304;
+	const char* CACHE_EXTENSION = ".nlc";
+
+	struct CacheHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		uint32_t scalarBytes;
+		uint32_t reserved;
+		uint64_t contentHash;
+		uint64_t contentCheck;
+		uint64_t sourceSize;
+		uint64_t numContours;
+		uint64_t numTrees;
+		uint64_t numPoints;
+		uint64_t numEdges;
+		uint64_t stringBytes;
+	};
+
+	struct ContourRecord {
+		uint64_t firstPoint;
+		uint64_t numPoints;
+		uint64_t name;
+		uint64_t color;
+		uint64_t closed;
+	};
+
+	struct TreeRecord {
+		uint64_t firstPoint;
+		uint64_t numPoints;
+		uint64_t firstEdge;
+		uint64_t numEdges;
+		uint64_t type;
+		uint64_t leaf;
+		uint64_t color;
+	};
+
+	inline uint64_t padded(uint64_t bytes) {
+		return (bytes + 7) & ~uint64_t(7);
+	}
+
+	/*!
+	 * \brief 64 bit MurmurHash64A of the data, processed in 64 bit words
+	 * The final mix of MurmurHash3 lets every input bit affect all bits of the hash.
+	 */
+	uint64_t content_hash(const char* data, size_t size) {
+		const uint64_t m = 0xc6a4a7935bd1e995ULL;
+		const int r = 47;
+		uint64_t hash = size * m;
+		size_t i = 0;
+		for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+			uint64_t word;
+			memcpy(&word, data + i, sizeof(uint64_t));
+			word *= m;
+			word ^= word >> r;
+			word *= m;
+			hash ^= word;
+			hash *= m;
+		}
+		if (i < size) {
+			uint64_t tail = 0;
+			memcpy(&tail, data + i, size - i);
+			hash ^= tail;
+			hash *= m;
+		}
+
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	/*!
+	 * \brief bytewise 64 bit FNV-1a hash of the data
+	 * Independent of content_hash, thus a cache hit requires both hashes to match.
+	 */
+	uint64_t content_check(const char* data, size_t size) {
+		const uint64_t prime = 1099511628211ULL;
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+		}
+		return hash;
+	}
+
+	/*!
+	 * \brief collects zero terminated strings and returns their offsets
+	 */
+	class StringTable {
+	public:
+		uint64_t add(const string& str) {
+			uint64_t offset = m_data.size();
+			m_data.insert(m_data.end(), str.begin(), str.end());
+			m_data.push_back('\0');
+			return offset;
+		}
+
+		const vector<char>& data() const {
+			return m_data;
+		}
+
+	private:
+		vector<char> m_data;
+	};
+
+	/*!
+	 * \brief returns the string at the offset or false if it is not valid
+	 */
+	bool read_string(const char* strings, uint64_t stringBytes, uint64_t offset, string& str) {
+		if (offset >= stringBytes) return false;
+		const char* begin = strings + offset;
+		const void* end = memchr(begin, '\0', stringBytes - offset);
+		if (!end) return false;
+		str.assign(begin, static_cast<const char*>(end));
+		return true;
+	}
+
+	template <typename T>
+	void write_array(ofstream& out, const vector<T>& values) {
+		if (!values.empty()) {
+			out.write(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(T));
+		}
+	}
+
+	template <typename TStore>
+	void append_points(const TStore& points, vector<typename TStore::scalar_type>& x, vector<typename TStore::scalar_type>& y,
+					   vector<typename TStore::scalar_type>& z, vector<typename TStore::scalar_type>& d) {
+		x.insert(x.end(), points.x().begin(), points.x().end());
+		y.insert(y.end(), points.y().begin(), points.y().end());
+		z.insert(z.end(), points.z().begin(), points.z().end());
+		d.insert(d.end(), points.d().begin(), points.d().end());
+	}
+
+	void write_padding(ofstream& out, uint64_t bytes) {
+		const char zeros[8] = {0};
+		out.write(zeros, padded(bytes) - bytes);
+	}
+}
+
+bool Neurolucida::find_cache_key(const std::string& filename, CacheKey& key) const {
+	MappedFile input;
+	if (!input.open(filename)) return false;
+
+	key.contentHash = content_hash(input.data(), input.size());
+	key.contentCheck = content_check(input.data(), input.size());
+	key.sourceSize = input.size();
+
+	stringstream ss;
+	ss << m_cacheDirectory << "/" << hex << setw(16) << setfill('0') << key.contentHash << CACHE_EXTENSION;
+	key.file = ss.str();
+	return true;
+}
+
+bool Neurolucida::load_cache(const CacheKey& key, std::vector<Contour>& contours, std::vector<Tree>& trees) const {
+	MappedFile cache;
+	if (!cache.open(key.file) || cache.size() < sizeof(CacheHeader)) return false;
+
+	typedef Points::scalar_type scalar;
+	CacheHeader header;
+	memcpy(&header, cache.data(), sizeof(CacheHeader));
+	if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+		|| header.version != CACHE_VERSION
+		|| header.byteOrder != CACHE_BYTE_ORDER
+		|| header.scalarBytes != sizeof(scalar)
+		|| header.contentHash != key.contentHash
+		|| header.contentCheck != key.contentCheck
+		|| header.sourceSize != key.sourceSize) {
+		NEUROLUCIDA_LOGN(LOG_SUMMARY, "ignoring outdated cache file '" << key.file << "'");
+		return false;
+	}
+
+	/// sizes are checked before any section is accessed (counts are bounded by the file size)
+	const uint64_t fileSize = cache.size();
+	if (header.numContours > fileSize || header.numTrees > fileSize || header.numPoints > fileSize
+		|| header.numEdges > fileSize || header.stringBytes > fileSize) {
+		return false;
+	}
+
+	const uint64_t contourOffset = sizeof(CacheHeader);
+	const uint64_t treeOffset = contourOffset + header.numContours * sizeof(ContourRecord);
+	const uint64_t pointOffset = treeOffset + header.numTrees * sizeof(TreeRecord);
+	const uint64_t edgeOffset = pointOffset + padded(4 * header.numPoints * sizeof(scalar));
+	const uint64_t stringOffset = edgeOffset + padded(2 * header.numEdges * sizeof(uint32_t));
+	if (stringOffset + padded(header.stringBytes) != fileSize) {
+		NEUROLUCIDA_LOGN(LOG_SUMMARY, "ignoring corrupt cache file '" << key.file << "'");
+		return false;
+	}
+
+	/// the mapping is page aligned, thus all sections are aligned
+	const char* data = cache.data();
+	const ContourRecord* contourRecords = reinterpret_cast<const ContourRecord*>(data + contourOffset);
+	const TreeRecord* treeRecords = reinterpret_cast<const TreeRecord*>(data + treeOffset);
+	const scalar* x = reinterpret_cast<const scalar*>(data + pointOffset);
+	const scalar* y = x + header.numPoints;
+	const scalar* z = y + header.numPoints;
+	const scalar* d = z + header.numPoints;
+	const uint32_t* from = reinterpret_cast<const uint32_t*>(data + edgeOffset);
+	const uint32_t* to = from + header.numEdges;
+	const char* strings = data + stringOffset;
+
+	contours.resize(header.numContours);
+	for (size_t i = 0; i < contours.size(); i++) {
+		const ContourRecord& record = contourRecords[i];
+		Contour& contour = contours[i];
+		if (record.firstPoint > header.numPoints || record.numPoints > header.numPoints - record.firstPoint
+			|| !read_string(strings, header.stringBytes, record.name, contour.name)
+			|| !read_string(strings, header.stringBytes, record.color, contour.color)) {
+			return false;
+		}
+		contour.closed = record.closed != 0;
+		size_t p = record.firstPoint;
+		contour.points.assign(x + p, y + p, z + p, d + p, record.numPoints);
+	}
+
+	trees.resize(header.numTrees);
+	for (size_t i = 0; i < trees.size(); i++) {
+		const TreeRecord& record = treeRecords[i];
+		Tree& t = trees[i];
+		if (record.firstPoint > header.numPoints || record.numPoints > header.numPoints - record.firstPoint
+			|| record.firstEdge > header.numEdges || record.numEdges > header.numEdges - record.firstEdge
+			|| !read_string(strings, header.stringBytes, record.type, t.type)
+			|| !read_string(strings, header.stringBytes, record.leaf, t.leaf)
+			|| !read_string(strings, header.stringBytes, record.color, t.color)) {
+			return false;
+		}
+		size_t p = record.firstPoint;
+		t.points.assign(x + p, y + p, z + p, d + p, record.numPoints);
+		t.edges.resize(record.numEdges);
+		for (size_t j = 0; j < record.numEdges; j++) {
+			size_t e = record.firstEdge + j;
+			if (from[e] >= record.numPoints || to[e] >= record.numPoints) return false;
+			t.edges[j].from = from[e];
+			t.edges[j].to = to[e];
+		}
+	}
+
+	return true;
+}
+
+void Neurolucida::write_cache(const CacheKey& key, const std::vector<Contour>& contours, const std::vector<Tree>& trees) const {
+	typedef Points::scalar_type scalar;
+	CacheHeader header;
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.byteOrder = CACHE_BYTE_ORDER;
+	header.scalarBytes = sizeof(scalar);
+	header.reserved = 0;
+	header.contentHash = key.contentHash;
+	header.contentCheck = key.contentCheck;
+	header.sourceSize = key.sourceSize;
+	header.numContours = contours.size();
+	header.numTrees = trees.size();
+
+	StringTable strings;
+	vector<scalar> x, y, z, d;
+	vector<uint32_t> from, to;
+	vector<ContourRecord> contourRecords(contours.size());
+	vector<TreeRecord> treeRecords(trees.size());
+
+	for (size_t i = 0; i < contours.size(); i++) {
+		const Contour& contour = contours[i];
+		ContourRecord& record = contourRecords[i];
+		record.firstPoint = x.size();
+		record.numPoints = contour.points.size();
+		record.name = strings.add(contour.name);
+		record.color = strings.add(contour.color);
+		record.closed = contour.closed;
+		append_points(contour.points, x, y, z, d);
+	}
+
+	for (size_t i = 0; i < trees.size(); i++) {
+		const Tree& t = trees[i];
+		TreeRecord& record = treeRecords[i];
+		record.firstPoint = x.size();
+		record.numPoints = t.points.size();
+		record.firstEdge = from.size();
+		record.numEdges = t.edges.size();
+		record.type = strings.add(t.type);
+		record.leaf = strings.add(t.leaf);
+		record.color = strings.add(t.color);
+		append_points(t.points, x, y, z, d);
+		for (size_t j = 0; j < t.edges.size(); j++) {
+			from.push_back(static_cast<uint32_t>(t.edges[j].from));
+			to.push_back(static_cast<uint32_t>(t.edges[j].to));
+		}
+	}
+
+	header.numPoints = x.size();
+	header.numEdges = from.size();
+	header.stringBytes = strings.data().size();
+
+	/// written under a unique name and renamed, so concurrent conversions never see partial files
+	stringstream ss;
+	ss << key.file << "." << this << "." << chrono::steady_clock::now().time_since_epoch().count() << ".tmp";
+	string tmpFile = ss.str();
+	{
+		ofstream out(tmpFile.c_str(), ios::binary);
+		if (!out) {
+			UG_LOGN("Could not write cache file '" << tmpFile << "'.");
+			return;
+		}
+		out.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+		write_array(out, contourRecords);
+		write_array(out, treeRecords);
+		write_array(out, x);
+		write_array(out, y);
+		write_array(out, z);
+		write_array(out, d);
+		write_padding(out, 4 * header.numPoints * sizeof(scalar));
+		write_array(out, from);
+		write_array(out, to);
+		write_padding(out, 2 * header.numEdges * sizeof(uint32_t));
+		write_array(out, strings.data());
+		write_padding(out, header.stringBytes);
+		if (!out) {
+			UG_LOGN("Could not write cache file '" << tmpFile << "'.");
+			out.close();
+			remove(tmpFile.c_str());
+			return;
+		}
+	}
+
+	/// rename does not replace existing files on all platforms
+	remove(key.file.c_str());
+	if (rename(tmpFile.c_str(), key.file.c_str()) != 0) {
+		UG_LOGN("Could not write cache file '" << key.file << "'.");
+		remove(tmpFile.c_str());
+		return;
+	}
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "stored document in cache '" << key.file << "'");
+}
@@ -0,0 +1,541 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_compression.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_compression.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef NEUROLUCIDA_WITH_ZLIB
+	#include <zlib.h>
+#endif
+#ifdef NEUROLUCIDA_WITH_ZSTD
+	#include <zstd.h>
+#endif
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	/// size of the chunks handed to the compressing thread respectively read from compressed files
+	const size_t CHUNK_SIZE = 1 << 20;
+	/// chunks waiting for compression, the producer blocks if there are more
+	const size_t MAX_QUEUED_CHUNKS = 4;
+
+	inline bool ends_with(const string& str, const string& suffix) {
+		return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	/*!
+	 * \brief compresses a stream of data and writes it to a file
+	 */
+	class Encoder {
+	public:
+		Encoder(int compression, FILE* file) : m_compression(compression),
+											   m_file(file),
+											   m_out(CHUNK_SIZE) {
+#ifdef NEUROLUCIDA_WITH_ZLIB
+			if (m_compression == COMPRESSION_GZIP) {
+				m_zstream.zalloc = Z_NULL;
+				m_zstream.zfree = Z_NULL;
+				m_zstream.opaque = Z_NULL;
+				/// 16 added to the window bits writes a gzip header instead of a zlib header
+				m_bValid = deflateInit2(&m_zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+			}
+#endif
+#ifdef NEUROLUCIDA_WITH_ZSTD
+			if (m_compression == COMPRESSION_ZSTD) {
+				m_cctx = ZSTD_createCCtx();
+				m_bValid = m_cctx != NULL;
+			}
+#endif
+		}
+
+		~Encoder() {
+#ifdef NEUROLUCIDA_WITH_ZLIB
+			if (m_compression == COMPRESSION_GZIP && m_bValid) deflateEnd(&m_zstream);
+#endif
+#ifdef NEUROLUCIDA_WITH_ZSTD
+			if (m_compression == COMPRESSION_ZSTD && m_bValid) ZSTD_freeCCtx(m_cctx);
+#endif
+		}
+
+		/*!
+		 * \brief compresses and writes the data, finish completes the compressed stream
+		 */
+		bool encode(const char* data, size_t size, bool finish) {
+			if (!m_bValid) return false;
+#ifdef NEUROLUCIDA_WITH_ZLIB
+			if (m_compression == COMPRESSION_GZIP) {
+				m_zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+				m_zstream.avail_in = static_cast<uInt>(size);
+				int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+				int ret;
+				do {
+					m_zstream.next_out = reinterpret_cast<Bytef*>(&m_out[0]);
+					m_zstream.avail_out = static_cast<uInt>(m_out.size());
+					ret = deflate(&m_zstream, flush);
+					if (ret == Z_STREAM_ERROR) return false;
+					if (!write(m_out.size() - m_zstream.avail_out)) return false;
+				} while (m_zstream.avail_out == 0 || (finish && ret != Z_STREAM_END));
+				return true;
+			}
+#endif
+#ifdef NEUROLUCIDA_WITH_ZSTD
+			if (m_compression == COMPRESSION_ZSTD) {
+				ZSTD_inBuffer in = {data, size, 0};
+				ZSTD_EndDirective mode = finish ? ZSTD_e_end : ZSTD_e_continue;
+				size_t remaining;
+				do {
+					ZSTD_outBuffer out = {&m_out[0], m_out.size(), 0};
+					remaining = ZSTD_compressStream2(m_cctx, &out, &in, mode);
+					if (ZSTD_isError(remaining)) return false;
+					if (!write(out.pos)) return false;
+				} while (finish ? remaining != 0 : in.pos < in.size);
+				return true;
+			}
+#endif
+#if !defined(NEUROLUCIDA_WITH_ZLIB) && !defined(NEUROLUCIDA_WITH_ZSTD)
+			/// no compression available, an encoder is never valid
+			(void) data;
+			(void) size;
+			(void) finish;
+#endif
+			return false;
+		}
+
+	private:
+		bool write(size_t size) {
+			return size == 0 || fwrite(&m_out[0], 1, size, m_file) == size;
+		}
+
+	private:
+		int m_compression;
+		FILE* m_file;
+		vector<char> m_out;
+		bool m_bValid = false;
+#ifdef NEUROLUCIDA_WITH_ZLIB
+		z_stream m_zstream;
+#endif
+#ifdef NEUROLUCIDA_WITH_ZSTD
+		ZSTD_CCtx* m_cctx = NULL;
+#endif
+	};
+}
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief stream buffer handing full chunks to a compressing thread
+		 */
+		class CompressingBuffer : public std::streambuf {
+		public:
+			CompressingBuffer(int compression, FILE* file) : m_file(file),
+															 m_encoder(compression, file),
+															 m_chunk(CHUNK_SIZE),
+															 m_bDone(false),
+															 m_bFailed(false) {
+				setp(&m_chunk[0], &m_chunk[0] + m_chunk.size());
+				m_thread = thread(&CompressingBuffer::run, this);
+			}
+
+			~CompressingBuffer() {
+				finish();
+			}
+
+			/*!
+			 * \brief compresses the remaining data and closes the file
+			 */
+			bool finish() {
+				if (!m_thread.joinable()) return !m_bFailed;
+				submit();
+				{
+					lock_guard<mutex> lock(m_mutex);
+					m_bDone = true;
+				}
+				m_cvWork.notify_one();
+				m_thread.join();
+				if (fclose(m_file) != 0) m_bFailed = true;
+				return !m_bFailed;
+			}
+
+		protected:
+			virtual int_type overflow(int_type c) {
+				if (!submit()) return traits_type::eof();
+				if (!traits_type::eq_int_type(c, traits_type::eof())) {
+					*pptr() = traits_type::to_char_type(c);
+					pbump(1);
+				}
+				return traits_type::not_eof(c);
+			}
+
+		private:
+			/*!
+			 * \brief queues the current chunk, blocks while too many chunks are waiting
+			 */
+			bool submit() {
+				size_t size = pptr() - pbase();
+				if (size > 0) {
+					m_chunk.resize(size);
+					unique_lock<mutex> lock(m_mutex);
+					m_cvSpace.wait(lock, [this]() { return m_queue.size() < MAX_QUEUED_CHUNKS || m_bFailed; });
+					m_queue.push_back(vector<char>());
+					m_queue.back().swap(m_chunk);
+					lock.unlock();
+					m_cvWork.notify_one();
+					m_chunk.resize(CHUNK_SIZE);
+				}
+				setp(&m_chunk[0], &m_chunk[0] + m_chunk.size());
+				return !m_bFailed;
+			}
+
+			void run() {
+				for (;;) {
+					vector<char> chunk;
+					bool done;
+					{
+						unique_lock<mutex> lock(m_mutex);
+						m_cvWork.wait(lock, [this]() { return !m_queue.empty() || m_bDone; });
+						done = m_queue.empty();
+						if (!done) {
+							chunk.swap(m_queue.front());
+							m_queue.pop_front();
+						}
+					}
+					m_cvSpace.notify_one();
+
+					bool ok = done ? m_encoder.encode(NULL, 0, true) : m_encoder.encode(&chunk[0], chunk.size(), false);
+					if (!ok) {
+						lock_guard<mutex> lock(m_mutex);
+						m_bFailed = true;
+						m_queue.clear();
+						m_cvSpace.notify_one();
+					}
+					if (done) return;
+				}
+			}
+
+		private:
+			FILE* m_file;
+			Encoder m_encoder;
+			vector<char> m_chunk;
+			deque<vector<char> > m_queue;
+			mutex m_mutex;
+			condition_variable m_cvWork;
+			condition_variable m_cvSpace;
+			thread m_thread;
+			bool m_bDone;
+			bool m_bFailed;
+		};
+
+		/*!
+		 * \brief stream buffer decompressing a file while it is read
+		 */
+		class DecompressingBuffer : public std::streambuf {
+		public:
+			DecompressingBuffer(int compression, FILE* file) : m_compression(compression),
+															   m_file(file),
+															   m_in(CHUNK_SIZE),
+															   m_out(CHUNK_SIZE),
+															   m_inPos(0),
+															   m_inSize(0),
+															   m_bValid(false),
+															   m_bEnd(false),
+															   m_bComplete(false),
+															   m_bPending(false) {
+#ifdef NEUROLUCIDA_WITH_ZLIB
+				if (m_compression == COMPRESSION_GZIP) {
+					m_zstream.zalloc = Z_NULL;
+					m_zstream.zfree = Z_NULL;
+					m_zstream.opaque = Z_NULL;
+					m_zstream.next_in = Z_NULL;
+					m_zstream.avail_in = 0;
+					/// 32 added to the window bits detects gzip and zlib headers
+					m_bValid = inflateInit2(&m_zstream, 15 + 32) == Z_OK;
+				}
+#endif
+#ifdef NEUROLUCIDA_WITH_ZSTD
+				if (m_compression == COMPRESSION_ZSTD) {
+					m_dctx = ZSTD_createDCtx();
+					m_bValid = m_dctx != NULL;
+				}
+#endif
+				setg(&m_out[0], &m_out[0], &m_out[0]);
+			}
+
+			~DecompressingBuffer() {
+#ifdef NEUROLUCIDA_WITH_ZLIB
+				if (m_compression == COMPRESSION_GZIP && m_bValid) inflateEnd(&m_zstream);
+#endif
+#ifdef NEUROLUCIDA_WITH_ZSTD
+				if (m_compression == COMPRESSION_ZSTD && m_bValid) ZSTD_freeDCtx(m_dctx);
+#endif
+				fclose(m_file);
+			}
+
+			/*!
+			 * \brief checks for decompression errors and, at the end of the file, for a truncated stream
+			 */
+			bool ok() const {
+				return m_bValid && (!m_bEnd || m_bComplete);
+			}
+
+		protected:
+			virtual int_type underflow() {
+				if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+				while (m_bValid && !m_bEnd) {
+					if (m_inPos == m_inSize && !m_bPending) {
+						m_inSize = fread(&m_in[0], 1, m_in.size(), m_file);
+						m_inPos = 0;
+						if (m_inSize == 0) {
+							m_bEnd = true;
+							break;
+						}
+					}
+					size_t produced = decode();
+					/// a full output buffer may leave decompressed data in the decoder, even without further input
+					m_bPending = produced == m_out.size();
+					if (produced > 0) {
+						setg(&m_out[0], &m_out[0], &m_out[0] + produced);
+						return traits_type::to_int_type(*gptr());
+					}
+				}
+				return traits_type::eof();
+			}
+
+		private:
+			/*!
+			 * \brief decompresses available input into the output buffer
+			 * \return number of bytes produced
+			 */
+			size_t decode() {
+#ifdef NEUROLUCIDA_WITH_ZLIB
+				if (m_compression == COMPRESSION_GZIP) {
+					m_zstream.next_in = reinterpret_cast<Bytef*>(&m_in[0] + m_inPos);
+					m_zstream.avail_in = static_cast<uInt>(m_inSize - m_inPos);
+					m_zstream.next_out = reinterpret_cast<Bytef*>(&m_out[0]);
+					m_zstream.avail_out = static_cast<uInt>(m_out.size());
+					int ret = inflate(&m_zstream, Z_NO_FLUSH);
+					m_inPos = m_inSize - m_zstream.avail_in;
+					if (ret == Z_STREAM_END) {
+						/// concatenated gzip members are read as one stream
+						inflateReset(&m_zstream);
+						m_bComplete = true;
+					} else if (ret == Z_OK) {
+						m_bComplete = false;
+					} else if (ret != Z_BUF_ERROR) {
+						m_bValid = false;
+					}
+					return m_out.size() - m_zstream.avail_out;
+				}
+#endif
+#ifdef NEUROLUCIDA_WITH_ZSTD
+				if (m_compression == COMPRESSION_ZSTD) {
+					ZSTD_inBuffer in = {&m_in[0] + m_inPos, m_inSize - m_inPos, 0};
+					ZSTD_outBuffer out = {&m_out[0], m_out.size(), 0};
+					size_t ret = ZSTD_decompressStream(m_dctx, &out, &in);
+					m_inPos += in.pos;
+					if (ZSTD_isError(ret)) m_bValid = false;
+					/// zero once a frame is decoded and flushed completely
+					m_bComplete = ret == 0;
+					return out.pos;
+				}
+#endif
+				return 0;
+			}
+
+		private:
+			int m_compression;
+			FILE* m_file;
+			vector<char> m_in;
+			vector<char> m_out;
+			size_t m_inPos;
+			size_t m_inSize;
+			bool m_bValid; ///<! no decompression error occurred
+			bool m_bEnd; ///<! end of the compressed file reached
+			bool m_bComplete; ///<! the last frame or gzip member ended
+			bool m_bPending; ///<! the decoder may still hold output
+#ifdef NEUROLUCIDA_WITH_ZLIB
+			z_stream m_zstream;
+#endif
+#ifdef NEUROLUCIDA_WITH_ZSTD
+			ZSTD_DCtx* m_dctx = NULL;
+#endif
+		};
+	}
+}
+
+bool ug::neurolucida::CompressionAvailable(int compression) {
+	switch (compression) {
+		case COMPRESSION_NONE:
+			return true;
+#ifdef NEUROLUCIDA_WITH_ZLIB
+		case COMPRESSION_GZIP:
+			return true;
+#endif
+#ifdef NEUROLUCIDA_WITH_ZSTD
+		case COMPRESSION_ZSTD:
+			return true;
+#endif
+		default:
+			return false;
+	}
+}
+
+std::string ug::neurolucida::CompressionExtension(int compression) {
+	switch (compression) {
+		case COMPRESSION_GZIP: return ".gz";
+		case COMPRESSION_ZSTD: return ".zst";
+		default: return "";
+	}
+}
+
+int ug::neurolucida::CompressionOfFile(const std::string& filename) {
+	if (ends_with(filename, CompressionExtension(COMPRESSION_GZIP))) return COMPRESSION_GZIP;
+	if (ends_with(filename, CompressionExtension(COMPRESSION_ZSTD))) return COMPRESSION_ZSTD;
+	return COMPRESSION_NONE;
+}
+
+std::string ug::neurolucida::StripCompressionExtension(const std::string& filename) {
+	return filename.substr(0, filename.size() - CompressionExtension(CompressionOfFile(filename)).size());
+}
+
+OutputFile::OutputFile() : std::ostream(NULL) {
+}
+
+OutputFile::~OutputFile() {
+	close();
+}
+
+bool OutputFile::open(const std::string& filename, int compression) {
+	close();
+	clear();
+	if (!CompressionAvailable(compression)) {
+		setstate(ios::failbit);
+		return false;
+	}
+
+	if (compression == COMPRESSION_NONE) {
+		if (!m_fileBuffer.open(filename.c_str(), ios::out | ios::binary)) {
+			setstate(ios::failbit);
+			return false;
+		}
+		rdbuf(&m_fileBuffer);
+		return true;
+	}
+
+	FILE* file = fopen(filename.c_str(), "wb");
+	if (!file) {
+		setstate(ios::failbit);
+		return false;
+	}
+	m_compressingBuffer.reset(new CompressingBuffer(compression, file));
+	rdbuf(m_compressingBuffer.get());
+	return true;
+}
+
+bool OutputFile::close() {
+	bool ok = !fail();
+	if (m_compressingBuffer) {
+		ok = m_compressingBuffer->finish() && ok;
+		m_compressingBuffer.reset();
+	} else if (m_fileBuffer.is_open()) {
+		ok = m_fileBuffer.close() != NULL && ok;
+	} else {
+		return ok;
+	}
+	rdbuf(NULL);
+	if (!ok) setstate(ios::failbit);
+	return ok;
+}
+
+bool OutputFile::is_open() const {
+	return m_compressingBuffer || m_fileBuffer.is_open();
+}
+
+InputFile::InputFile() : std::istream(NULL) {
+}
+
+InputFile::~InputFile() {
+	close();
+}
+
+bool InputFile::open(const std::string& filename) {
+	close();
+	clear();
+	int compression = CompressionOfFile(filename);
+	if (!CompressionAvailable(compression)) {
+		setstate(ios::failbit);
+		return false;
+	}
+
+	if (compression == COMPRESSION_NONE) {
+		if (!m_fileBuffer.open(filename.c_str(), ios::in | ios::binary)) {
+			setstate(ios::failbit);
+			return false;
+		}
+		rdbuf(&m_fileBuffer);
+		return true;
+	}
+
+	FILE* file = fopen(filename.c_str(), "rb");
+	if (!file) {
+		setstate(ios::failbit);
+		return false;
+	}
+	m_decompressingBuffer.reset(new DecompressingBuffer(compression, file));
+	rdbuf(m_decompressingBuffer.get());
+	return true;
+}
+
+bool InputFile::ok() const {
+	if (m_decompressingBuffer) return m_decompressingBuffer->ok();
+	return !bad();
+}
+
+void InputFile::close() {
+	rdbuf(NULL);
+	m_decompressingBuffer.reset();
+	if (m_fileBuffer.is_open()) m_fileBuffer.close();
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_compression.h
+ * \brief gzip and zstd compressed input and output files
+ *
+ * Compression is available if the plugin is built with zlib (gzip) respectively
+ * libzstd (zstd), i.e. NEUROLUCIDA_WITH_ZLIB respectively NEUROLUCIDA_WITH_ZSTD
+ * is defined. Output is compressed on a separate thread: data written to an
+ * OutputFile is collected in chunks which are compressed and written by a
+ * worker thread while the caller continues producing the next chunk.
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_COMPRESSION__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_COMPRESSION__
+
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief compression formats
+		 */
+		enum Compression {
+			COMPRESSION_NONE = 0,
+			COMPRESSION_GZIP = 1,
+			COMPRESSION_ZSTD = 2
+		};
+
+		/*!
+		 * \brief checks if the plugin was built with support for the compression
+		 */
+		bool CompressionAvailable(int compression);
+
+		/*!
+		 * \brief file extension of the compression, e.g. ".gz", empty for none
+		 */
+		std::string CompressionExtension(int compression);
+
+		/*!
+		 * \brief compression of a file given by its extension
+		 */
+		int CompressionOfFile(const std::string& filename);
+
+		/*!
+		 * \brief strips the extension of the compression from the file name, if any
+		 */
+		std::string StripCompressionExtension(const std::string& filename);
+
+		class CompressingBuffer;
+		class DecompressingBuffer;
+
+		/*!
+		 * \brief output file, optionally compressed on a separate thread
+		 */
+		class OutputFile : public std::ostream {
+		public:
+			OutputFile();
+			~OutputFile();
+
+			/*!
+			 * \brief opens the file
+			 * \param[in] compression one of Compression
+			 * \return false if the file could not be opened or the compression is not available
+			 */
+			bool open(const std::string& filename, int compression = COMPRESSION_NONE);
+
+			/*!
+			 * \brief writes all remaining data and closes the file
+			 * \return false if not all data could be written
+			 */
+			bool close();
+
+			bool is_open() const;
+
+		private:
+			/// not copyable
+			OutputFile(const OutputFile&);
+			OutputFile& operator=(const OutputFile&);
+
+		private:
+			std::filebuf m_fileBuffer;
+			std::unique_ptr<CompressingBuffer> m_compressingBuffer;
+		};
+
+		/*!
+		 * \brief input file, decompressed while read if its extension is the one of a compression
+		 */
+		class InputFile : public std::istream {
+		public:
+			InputFile();
+			~InputFile();
+
+			/*!
+			 * \return false if the file could not be opened or the compression is not available
+			 */
+			bool open(const std::string& filename);
+
+			/*!
+			 * \return false if decompression failed or, once the end was read, the compressed data was truncated
+			 * Errors of a decompressing stream only show up here, not in the stream state.
+			 */
+			bool ok() const;
+
+			void close();
+
+		private:
+			/// not copyable
+			InputFile(const InputFile&);
+			InputFile& operator=(const InputFile&);
+
+		private:
+			std::filebuf m_fileBuffer;
+			std::unique_ptr<DecompressingBuffer> m_decompressingBuffer;
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_COMPRESSION__
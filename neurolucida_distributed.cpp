@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_distributed.cpp
+ * \brief conversion of many files distributed across the processes of a parallel run
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida.h"
+
+#include <chrono>
+#include <cstring>
+
+#ifdef UG_PARALLEL
+	#include <mpi.h>
+	#include "pcl/pcl_process_communicator.h"
+#endif
+
+using namespace ug::neurolucida;
+using namespace std;
+
+#ifdef UG_PARALLEL
+namespace {
+	/*!
+	 * \brief appends the bytes of a value to a message
+	 */
+	template <typename T>
+	void append(std::string& buffer, const T& value) {
+		buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	/*!
+	 * \brief reads a value appended to a message
+	 */
+	template <typename T>
+	void extract(const char*& data, T& value) {
+		memcpy(&value, data, sizeof(T));
+		data += sizeof(T);
+	}
+}
+#endif
+
+size_t Neurolucida::convert_distributed(const std::string& listOrDirectory) {
+	vector<string> filenames;
+	collect_batch_files(listOrDirectory, filenames);
+	return convert_distributed(filenames);
+}
+
+size_t Neurolucida::convert_distributed(const std::vector<std::string>& filenames) {
+#ifndef UG_PARALLEL
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "Built without UG_PARALLEL, converting on a single process.");
+	return convert_batch(filenames, 1);
+#else
+	MPI_Comm comm = pcl::ProcessCommunicator().get_mpi_communicator();
+	int rank, numProcs;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &numProcs);
+
+	m_batchResults.clear();
+	m_batchResults.resize(filenames.size());
+	for (size_t i = 0; i < filenames.size(); i++) {
+		m_batchResults[i].filename = filenames[i];
+	}
+
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "Converting " << filenames.size() << " files on " << numProcs << " processes.");
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	/// a converting process answers requests only between files, thus with several processes
+	/// process 0 only hands out files, waiting for requests all the time
+	const int TAG_REQUEST = 1;
+	const int TAG_FILE = 2;
+	const long numFiles = static_cast<long>(filenames.size());
+	IdleConverters idle;
+	std::vector<size_t> converted;
+	if (numProcs > 1 && rank == 0) {
+		long nextFile = 0;
+		int numDone = 0;
+		while (numDone < numProcs - 1) {
+			MPI_Status status;
+			MPI_Recv(NULL, 0, MPI_LONG, MPI_ANY_SOURCE, TAG_REQUEST, comm, &status);
+			long index = nextFile < numFiles ? nextFile++ : numFiles;
+			if (index == numFiles) numDone++;
+			MPI_Send(&index, 1, MPI_LONG, status.MPI_SOURCE, TAG_FILE, comm);
+		}
+	} else {
+		long nextFile = 0;
+		for (;;) {
+			long index = nextFile++;
+			/// whenever a process has finished a file it requests the next one not yet taken
+			if (numProcs > 1) {
+				MPI_Sendrecv(NULL, 0, MPI_LONG, 0, TAG_REQUEST, &index, 1, MPI_LONG, 0, TAG_FILE, comm, MPI_STATUS_IGNORE);
+			}
+			if (index >= numFiles) break;
+
+			convert_batch_file(m_batchResults[index], idle);
+			converted.push_back(static_cast<size_t>(index));
+		}
+	}
+	for (size_t i = 0; i < idle.converters.size(); i++) {
+		destroy_converter(idle.converters[i]);
+	}
+
+	/// results of the files converted by this process
+	std::string message;
+	for (size_t i = 0; i < converted.size(); i++) {
+		const BatchResult& result = m_batchResults[converted[i]];
+		append(message, static_cast<uint64_t>(converted[i]));
+		append(message, static_cast<char>(result.success));
+		append(message, result.seconds);
+		append(message, static_cast<uint64_t>(result.points));
+		append(message, static_cast<uint64_t>(result.bytesWritten));
+		append(message, static_cast<uint64_t>(result.message.size()));
+		message.append(result.message);
+	}
+
+	int messageSize = static_cast<int>(message.size());
+	std::vector<int> sizes(rank == 0 ? numProcs : 0);
+	MPI_Gather(&messageSize, 1, MPI_INT, rank == 0 ? &sizes[0] : NULL, 1, MPI_INT, 0, comm);
+
+	std::vector<int> offsets(sizes.size(), 0);
+	size_t totalSize = 0;
+	for (size_t p = 0; p < sizes.size(); p++) {
+		offsets[p] = static_cast<int>(totalSize);
+		totalSize += sizes[p];
+	}
+	std::vector<char> messages(totalSize + 1);
+	MPI_Gatherv(message.empty() ? NULL : &message[0], messageSize, MPI_CHAR, &messages[0],
+				rank == 0 ? &sizes[0] : NULL, rank == 0 ? &offsets[0] : NULL, MPI_CHAR, 0, comm);
+
+	unsigned long numSuccess = 0;
+	if (rank == 0) {
+		const char* data = &messages[0];
+		const char* end = data + totalSize;
+		while (data < end) {
+			uint64_t index, points, bytesWritten, length;
+			char success;
+			double seconds;
+			extract(data, index);
+			extract(data, success);
+			extract(data, seconds);
+			extract(data, points);
+			extract(data, bytesWritten);
+			extract(data, length);
+			BatchResult& result = m_batchResults[index];
+			result.success = success != 0;
+			result.seconds = seconds;
+			result.points = static_cast<size_t>(points);
+			result.bytesWritten = static_cast<size_t>(bytesWritten);
+			result.message.assign(data, length);
+			data += length;
+			if (result.success) numSuccess++;
+		}
+	}
+	MPI_Bcast(&numSuccess, 1, MPI_UNSIGNED_LONG, 0, comm);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	if (rank == 0) {
+		if (m_logLevel >= LOG_SUMMARY) print_batch_report();
+		NEUROLUCIDA_LOGN(LOG_SUMMARY, "Converted " << numSuccess << " of " << m_batchResults.size() << " files on "
+						 << numProcs << " processes in " << seconds << " s.");
+	}
+	return numSuccess;
+#endif
+}
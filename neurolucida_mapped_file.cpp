@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_mapped_file.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_mapped_file.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	bool file_status(const string& filename, size_t& size, time_t& modificationTime) {
+		struct stat status;
+		if (stat(filename.c_str(), &status) != 0) return false;
+		size = static_cast<size_t>(status.st_size);
+		modificationTime = status.st_mtime;
+		return true;
+	}
+
+	size_t page_size() {
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return static_cast<size_t>(info.dwPageSize);
+#else
+		return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}
+}
+
+MappedFile::MappedFile() : m_data(NULL),
+						   m_size(0),
+						   m_modificationTime(0)
+#ifdef _WIN32
+						   , m_hFile(NULL),
+						   m_hMapping(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const string& filename) {
+	close();
+
+	size_t size;
+	time_t modificationTime;
+	if (!file_status(filename, size, modificationTime) || size == 0) return false;
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hMapping) {
+		CloseHandle(hFile);
+		return false;
+	}
+	const void* data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+	m_hFile = hFile;
+	m_hMapping = hMapping;
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd == -1) return false;
+	void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); /// the mapping stays valid after closing the descriptor
+	if (data == MAP_FAILED) return false;
+	madvise(data, size, MADV_SEQUENTIAL);
+#endif
+
+	m_data = static_cast<const char*>(data);
+	m_size = size;
+	m_filename = filename;
+	m_modificationTime = modificationTime;
+	return true;
+}
+
+void MappedFile::close() {
+	if (!m_data) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle(static_cast<HANDLE>(m_hMapping));
+	CloseHandle(static_cast<HANDLE>(m_hFile));
+	m_hMapping = NULL;
+	m_hFile = NULL;
+#else
+	munmap(const_cast<char*>(m_data), m_size);
+#endif
+
+	m_data = NULL;
+	m_size = 0;
+	m_filename.clear();
+	m_modificationTime = 0;
+}
+
+bool MappedFile::is_current(const string& filename) const {
+	if (!m_data || filename != m_filename) return false;
+	size_t size;
+	time_t modificationTime;
+	if (!file_status(filename, size, modificationTime)) return false;
+	return size == m_size && modificationTime == m_modificationTime;
+}
+
+bool MappedFile::is_zero_terminated() const {
+	return m_data && (m_size % page_size()) != 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_mapped_file.h
+ * \brief read-only memory mapping of an input file
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_MAPPED_FILE__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_MAPPED_FILE__
+
+#include <string>
+#include <ctime>
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief maps a whole file read-only into memory
+		 * The mapping is released on close, on destruction or when another file is opened.
+		 */
+		class MappedFile {
+		public:
+			MappedFile();
+			~MappedFile();
+
+			/*!
+			 * \brief maps the given file
+			 * \return false if the file could not be opened or mapped
+			 */
+			bool open(const std::string& filename);
+
+			/*!
+			 * \brief unmaps the current file
+			 */
+			void close();
+
+			/*!
+			 * \brief checks if the given file is mapped and did not change on disk since
+			 */
+			bool is_current(const std::string& filename) const;
+
+			/*!
+			 * \brief checks if the mapping is followed by a zero byte
+			 * This is the case whenever the file size is not a multiple of the page
+			 * size, because the remainder of the last page is filled with zeros.
+			 */
+			bool is_zero_terminated() const;
+
+			inline const char* data() const {
+				return m_data;
+			}
+
+			inline size_t size() const {
+				return m_size;
+			}
+
+			inline bool is_open() const {
+				return m_data != NULL;
+			}
+
+		private:
+			/// not copyable
+			MappedFile(const MappedFile&);
+			MappedFile& operator=(const MappedFile&);
+
+		private:
+			const char* m_data;
+			size_t m_size;
+			std::string m_filename;
+			std::time_t m_modificationTime;
+#ifdef _WIN32
+			void* m_hFile;
+			void* m_hMapping;
+#endif
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_MAPPED_FILE__
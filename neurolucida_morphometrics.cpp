@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_morphometrics.cpp
+ * \brief morphometrics of the parsed trees, computed without a grid
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_morphometrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	const number MORPHOMETRICS_PI = 3.14159265358979323846;
+}
+
+Morphometrics::Morphometrics(number shollStep) : m_shollStep(shollStep) {
+	clear();
+}
+
+void Morphometrics::clear() {
+	m_numTrees = 0;
+	m_numSegments = 0;
+	m_numBranchPoints = 0;
+	m_numTips = 0;
+	m_length = 0;
+	m_area = 0;
+	m_volume = 0;
+	m_branchesPerOrder.clear();
+	m_lengthPerOrder.clear();
+	m_bHasCenter = false;
+	m_bHasRoot = false;
+	m_shollDifferences.clear();
+	m_shollIntersections.clear();
+	m_deferred.clear();
+}
+
+void Morphometrics::clear_segments(size_t numSegments) {
+	m_order.resize(numSegments);
+	m_x0.resize(numSegments);
+	m_y0.resize(numSegments);
+	m_z0.resize(numSegments);
+	m_d0.resize(numSegments);
+	m_x1.resize(numSegments);
+	m_y1.resize(numSegments);
+	m_z1.resize(numSegments);
+	m_d1.resize(numSegments);
+}
+
+void Morphometrics::count_branch(size_t order) {
+	if (order >= m_branchesPerOrder.size()) m_branchesPerOrder.resize(order + 1, 0);
+	m_branchesPerOrder[order]++;
+}
+
+void Morphometrics::add_segments() {
+	const size_t n = m_x0.size();
+	m_segmentLength.resize(n);
+	const number* x0 = &m_x0[0];
+	const number* y0 = &m_y0[0];
+	const number* z0 = &m_z0[0];
+	const number* d0 = &m_d0[0];
+	const number* x1 = &m_x1[0];
+	const number* y1 = &m_y1[0];
+	const number* z1 = &m_z1[0];
+	const number* d1 = &m_d1[0];
+	number* segmentLength = &m_segmentLength[0];
+
+	/// frustum per segment, a loop without branches over separate arrays which the compiler vectorizes
+	number length = 0;
+	number area = 0;
+	number volume = 0;
+	for (size_t i = 0; i < n; i++) {
+		const number dx = x1[i] - x0[i];
+		const number dy = y1[i] - y0[i];
+		const number dz = z1[i] - z0[i];
+		const number l = std::sqrt(dx * dx + dy * dy + dz * dz);
+		const number r0 = number(0.5) * d0[i];
+		const number r1 = number(0.5) * d1[i];
+		const number dr = r1 - r0;
+		segmentLength[i] = l;
+		length += l;
+		area += (r0 + r1) * std::sqrt(dr * dr + l * l);
+		volume += l * (r0 * r0 + r0 * r1 + r1 * r1);
+	}
+	m_length += length;
+	m_area += MORPHOMETRICS_PI * area;
+	m_volume += MORPHOMETRICS_PI / 3 * volume;
+	m_numSegments += n;
+
+	for (size_t i = 0; i < n; i++) {
+		if (m_order[i] >= m_lengthPerOrder.size()) m_lengthPerOrder.resize(m_order[i] + 1, 0);
+		m_lengthPerOrder[m_order[i]] += segmentLength[i];
+	}
+
+	if (!m_bHasCenter) {
+		/// the Sholl profile of trees before the soma is computed once the center is known
+		for (size_t i = 0; i < n; i++) {
+			m_deferred.push_back(ug::vector3(x0[i], y0[i], z0[i]));
+			m_deferred.push_back(ug::vector3(x1[i], y1[i], z1[i]));
+		}
+		return;
+	}
+
+	m_r0.resize(n);
+	m_r1.resize(n);
+	number* r0 = &m_r0[0];
+	number* r1 = &m_r1[0];
+	const number cx = m_center[0];
+	const number cy = m_center[1];
+	const number cz = m_center[2];
+	for (size_t i = 0; i < n; i++) {
+		r0[i] = std::sqrt((x0[i] - cx) * (x0[i] - cx) + (y0[i] - cy) * (y0[i] - cy) + (z0[i] - cz) * (z0[i] - cz));
+		r1[i] = std::sqrt((x1[i] - cx) * (x1[i] - cx) + (y1[i] - cy) * (y1[i] - cy) + (z1[i] - cz) * (z1[i] - cz));
+	}
+	add_sholl(r0, r1, n);
+}
+
+void Morphometrics::add_sholl(const number* r0, const number* r1, size_t numSegments) {
+	if (m_shollStep <= 0) return;
+	for (size_t i = 0; i < numSegments; i++) {
+		/// the segment crosses all spheres with a radius in (min, max]
+		const number lower = std::min(r0[i], r1[i]);
+		const number upper = std::max(r0[i], r1[i]);
+		const size_t first = static_cast<size_t>(std::floor(lower / m_shollStep)) + 1;
+		const size_t last = static_cast<size_t>(std::floor(upper / m_shollStep));
+		if (first > last) continue;
+		if (last + 2 > m_shollDifferences.size()) m_shollDifferences.resize(last + 2, 0);
+		m_shollDifferences[first]++;
+		m_shollDifferences[last + 1]--;
+	}
+}
+
+void Morphometrics::set_center(const ug::vector3& center) {
+	m_center = center;
+	m_bHasCenter = true;
+
+	const size_t n = m_deferred.size() / 2;
+	std::vector<number> r0(n);
+	std::vector<number> r1(n);
+	for (size_t i = 0; i < n; i++) {
+		r0[i] = VecDistance(m_deferred[2*i], m_center);
+		r1[i] = VecDistance(m_deferred[2*i+1], m_center);
+	}
+	if (n > 0) add_sholl(&r0[0], &r1[0], n);
+	m_deferred.clear();
+}
+
+void Morphometrics::finish() {
+	if (!m_bHasCenter && m_bHasRoot) set_center(m_root);
+
+	m_shollIntersections.resize(m_shollDifferences.empty() ? 0 : m_shollDifferences.size() - 1);
+	long intersections = 0;
+	for (size_t i = 0; i < m_shollIntersections.size(); i++) {
+		intersections += m_shollDifferences[i];
+		m_shollIntersections[i] = static_cast<size_t>(intersections);
+	}
+}
+
+void Morphometrics::write_csv(std::ostream& out) const {
+	out << "metric,value\n";
+	out << "trees," << m_numTrees << "\n";
+	out << "segments," << m_numSegments << "\n";
+	out << "branch_points," << m_numBranchPoints << "\n";
+	out << "tips," << m_numTips << "\n";
+	out << "total_length," << m_length << "\n";
+	out << "surface_area," << m_area << "\n";
+	out << "volume," << m_volume << "\n";
+	for (size_t i = 0; i < m_branchesPerOrder.size(); i++) {
+		out << "branches_order_" << i << "," << m_branchesPerOrder[i] << "\n";
+	}
+	for (size_t i = 0; i < m_lengthPerOrder.size(); i++) {
+		out << "length_order_" << i << "," << m_lengthPerOrder[i] << "\n";
+	}
+	out << "sholl_step," << m_shollStep << "\n";
+	for (size_t i = 0; i < m_shollIntersections.size(); i++) {
+		out << "sholl_" << i * m_shollStep << "," << m_shollIntersections[i] << "\n";
+	}
+}
+
+void Morphometrics::write_json(std::ostream& out) const {
+	out << "{\n";
+	out << "\t\"trees\": " << m_numTrees << ",\n";
+	out << "\t\"segments\": " << m_numSegments << ",\n";
+	out << "\t\"branch_points\": " << m_numBranchPoints << ",\n";
+	out << "\t\"tips\": " << m_numTips << ",\n";
+	out << "\t\"total_length\": " << m_length << ",\n";
+	out << "\t\"surface_area\": " << m_area << ",\n";
+	out << "\t\"volume\": " << m_volume << ",\n";
+	out << "\t\"branch_orders\": [";
+	for (size_t i = 0; i < m_branchesPerOrder.size(); i++) {
+		out << (i ? ", " : "") << "{\"order\": " << i << ", \"branches\": " << m_branchesPerOrder[i]
+			<< ", \"length\": " << (i < m_lengthPerOrder.size() ? m_lengthPerOrder[i] : 0) << "}";
+	}
+	out << "],\n";
+	out << "\t\"sholl\": {\"step\": " << m_shollStep << ", \"intersections\": [";
+	for (size_t i = 0; i < m_shollIntersections.size(); i++) {
+		out << (i ? ", " : "") << m_shollIntersections[i];
+	}
+	out << "]}\n";
+	out << "}\n";
+}
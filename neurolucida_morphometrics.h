@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_morphometrics.h
+ * \brief morphometrics of the parsed trees, computed without a grid
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_MORPHOMETRICS__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_MORPHOMETRICS__
+
+#include <ostream>
+#include <vector>
+
+#include <common/math/ugmath.h>
+
+#include "neurolucida_point_store.h"
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief length, surface area, volume, branch orders and Sholl profile of trees
+		 * Trees are added as they are parsed, in the units of the file. Each edge
+		 * of a tree is a segment, i.e. a frustum between the diameters of its points.
+		 * The surface area is the lateral area of the frustums. The branch order of
+		 * a segment is the number of branch points between it and the root. Sholl
+		 * intersections are counted on spheres around the center of the first soma
+		 * contour (or the root of the first tree if there is no soma), with radii
+		 * of multiples of the Sholl step.
+		 */
+		class Morphometrics {
+		public:
+			explicit Morphometrics(number shollStep = 10);
+
+			/*!
+			 * \brief removes all trees, the capacity is kept
+			 */
+			void clear();
+
+			inline void set_sholl_step(number shollStep) {
+				m_shollStep = shollStep;
+			}
+
+			inline number get_sholl_step() const {
+				return m_shollStep;
+			}
+
+			/*!
+			 * \brief uses the centroid of the soma contour as Sholl center, unless already set
+			 */
+			template <typename TScalar>
+			void add_soma(const PointStore<TScalar>& points) {
+				if (m_bHasCenter || points.empty()) return;
+				ug::vector3 center(0, 0, 0);
+				for (size_t i = 0; i < points.size(); i++) {
+					VecAdd(center, center, points.position(i));
+				}
+				VecScale(center, center, number(1) / points.size());
+				set_center(center);
+			}
+
+			/*!
+			 * \brief adds a tree given by its points and edges from parent to child point
+			 * Edges have to be ordered such that the edge to a point comes before the
+			 * edges from it, as for parsed trees.
+			 */
+			template <typename TScalar, typename TEdge>
+			void add_tree(const PointStore<TScalar>& points, const std::vector<TEdge>& edges) {
+				if (edges.empty()) return;
+				const size_t numPoints = points.size();
+				m_numIn.assign(numPoints, 0);
+				m_numOut.assign(numPoints, 0);
+				m_pointOrder.assign(numPoints, 0);
+				for (size_t e = 0; e < edges.size(); e++) {
+					m_numIn[edges[e].to]++;
+					m_numOut[edges[e].from]++;
+				}
+
+				/// segments are gathered into separate arrays for the frustum math
+				clear_segments(edges.size());
+				for (size_t e = 0; e < edges.size(); e++) {
+					const size_t from = edges[e].from;
+					const size_t to = edges[e].to;
+					bool branchStart = m_numIn[from] == 0 || m_numOut[from] > 1;
+					m_pointOrder[to] = m_pointOrder[from] + (m_numOut[from] > 1 ? 1 : 0);
+					if (branchStart) count_branch(m_pointOrder[to]);
+					m_order[e] = m_pointOrder[to];
+					m_x0[e] = points.x()[from];
+					m_y0[e] = points.y()[from];
+					m_z0[e] = points.z()[from];
+					m_d0[e] = points.d()[from];
+					m_x1[e] = points.x()[to];
+					m_y1[e] = points.y()[to];
+					m_z1[e] = points.z()[to];
+					m_d1[e] = points.d()[to];
+				}
+
+				for (size_t i = 0; i < numPoints; i++) {
+					if (m_numOut[i] > 1) m_numBranchPoints++;
+					if (m_numIn[i] > 0 && m_numOut[i] == 0) m_numTips++;
+				}
+				if (!m_bHasRoot) {
+					m_root = points.position(edges.front().from);
+					m_bHasRoot = true;
+				}
+				m_numTrees++;
+				add_segments();
+			}
+
+			/*!
+			 * \brief completes the Sholl profile, to be called after all trees were added
+			 */
+			void finish();
+
+			/*!
+			 * \brief writes the metrics as name,value lines
+			 */
+			void write_csv(std::ostream& out) const;
+
+			/*!
+			 * \brief writes the metrics as JSON object
+			 */
+			void write_json(std::ostream& out) const;
+
+			inline size_t num_trees() const {return m_numTrees;}
+			inline size_t num_segments() const {return m_numSegments;}
+			inline size_t num_branch_points() const {return m_numBranchPoints;}
+			inline size_t num_tips() const {return m_numTips;}
+			inline number total_length() const {return m_length;}
+			inline number surface_area() const {return m_area;}
+			inline number volume() const {return m_volume;}
+
+			/*!
+			 * \brief number of branches per branch order
+			 */
+			inline const std::vector<size_t>& branch_order_histogram() const {return m_branchesPerOrder;}
+
+			/*!
+			 * \brief length per branch order
+			 */
+			inline const std::vector<number>& length_per_order() const {return m_lengthPerOrder;}
+
+			/*!
+			 * \brief intersections with the spheres of radius i * Sholl step, i = 0, 1, ...
+			 */
+			inline const std::vector<size_t>& sholl_intersections() const {return m_shollIntersections;}
+
+		private:
+			void set_center(const ug::vector3& center);
+			void clear_segments(size_t numSegments);
+			void count_branch(size_t order);
+
+			/*!
+			 * \brief adds the gathered segments to the totals and the Sholl profile
+			 */
+			void add_segments();
+
+			/*!
+			 * \brief adds the segments with the given distances of their points from the center to the Sholl profile
+			 */
+			void add_sholl(const number* r0, const number* r1, size_t numSegments);
+
+		private:
+			number m_shollStep;
+			size_t m_numTrees;
+			size_t m_numSegments;
+			size_t m_numBranchPoints;
+			size_t m_numTips;
+			number m_length;
+			number m_area;
+			number m_volume;
+			std::vector<size_t> m_branchesPerOrder;
+			std::vector<number> m_lengthPerOrder;
+
+			ug::vector3 m_center;
+			bool m_bHasCenter;
+			ug::vector3 m_root; ///<! root of the first tree, center if there is no soma
+			bool m_bHasRoot;
+			/// differences of the intersections of consecutive spheres
+			std::vector<long> m_shollDifferences;
+			std::vector<size_t> m_shollIntersections;
+			/// end points of segments added before the center was known
+			std::vector<ug::vector3> m_deferred;
+
+			/// per point and per segment arrays of the tree being added
+			std::vector<size_t> m_numIn;
+			std::vector<size_t> m_numOut;
+			std::vector<size_t> m_pointOrder;
+			std::vector<size_t> m_order;
+			std::vector<number> m_x0, m_y0, m_z0, m_d0;
+			std::vector<number> m_x1, m_y1, m_z1, m_d1;
+			std::vector<number> m_segmentLength;
+			std::vector<number> m_r0, m_r1;
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_MORPHOMETRICS__
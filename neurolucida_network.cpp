@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_network.cpp
+ * \brief assembly of networks of cells into one grid and their partitioning
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida.h"
+#include "neurolucida_thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "lib_grid/file_io/file_io_ugx.h"
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	/*!
+	 * \brief orders edges by one coordinate of their centers, ties by their index
+	 */
+	struct CenterLess {
+		const std::vector<ug::vector3>& centers;
+		size_t axis;
+
+		CenterLess(const std::vector<ug::vector3>& centers, size_t axis) : centers(centers),
+																		 axis(axis) {
+		}
+
+		bool operator()(size_t a, size_t b) const {
+			if (centers[a][axis] != centers[b][axis]) return centers[a][axis] < centers[b][axis];
+			return a < b;
+		}
+	};
+
+	/*!
+	 * \brief recursive coordinate bisection
+	 * Splits the elements at the longest extent of their bounding box, in proportion
+	 * to the number of partitions of each side.
+	 */
+	void Bisect(std::vector<size_t>::iterator begin, std::vector<size_t>::iterator end,
+				const std::vector<ug::vector3>& centers, size_t numParts, int firstPart, std::vector<int>& part) {
+		if (numParts == 1 || begin == end) {
+			for (std::vector<size_t>::iterator it = begin; it != end; ++it) {
+				part[*it] = firstPart;
+			}
+			return;
+		}
+
+		ug::vector3 lower = centers[*begin];
+		ug::vector3 upper = centers[*begin];
+		for (std::vector<size_t>::iterator it = begin; it != end; ++it) {
+			for (size_t i = 0; i < 3; i++) {
+				lower[i] = std::min(lower[i], centers[*it][i]);
+				upper[i] = std::max(upper[i], centers[*it][i]);
+			}
+		}
+		size_t axis = 0;
+		for (size_t i = 1; i < 3; i++) {
+			if (upper[i] - lower[i] > upper[axis] - lower[axis]) axis = i;
+		}
+
+		size_t leftParts = numParts / 2;
+		std::vector<size_t>::iterator mid = begin + (end - begin) * leftParts / numParts;
+		std::nth_element(begin, mid, end, CenterLess(centers, axis));
+		Bisect(begin, mid, centers, leftParts, firstPart, part);
+		Bisect(mid, end, centers, numParts - leftParts, firstPart + static_cast<int>(leftParts), part);
+	}
+}
+
+void Neurolucida::add_network_cell(const std::string& filename, const std::vector<number>& transform) {
+	NetworkCell cell;
+	cell.filename = filename;
+	cell.firstSubset = 0;
+	cell.numSubsets = 0;
+	cell.numVertices = 0;
+
+	/// identity
+	for (size_t i = 0; i < 12; i++) {
+		cell.transform[i] = (i % 5 == 0) ? 1 : 0;
+	}
+
+	if (transform.size() == 3) {
+		for (size_t r = 0; r < 3; r++) {
+			cell.transform[4*r+3] = transform[r];
+		}
+	} else if (transform.size() == 12 || transform.size() == 16) {
+		std::copy(transform.begin(), transform.begin() + 12, cell.transform);
+		UG_COND_THROW(transform.size() == 16 && (transform[12] != 0 || transform[13] != 0 || transform[14] != 0 || transform[15] != 1),
+					  "Transform of cell '" << filename << "' is not affine.");
+	} else {
+		UG_COND_THROW(!transform.empty(), "Transform of cell '" << filename << "' has " << transform.size()
+					  << " values, expected 0, 3, 12 or 16.");
+	}
+
+	m_networkCells.push_back(cell);
+	m_bNetworkAssembled = false;
+}
+
+void Neurolucida::read_network(const std::string& networkFile) {
+	ifstream in(networkFile.c_str());
+	UG_COND_THROW(!in, "Could not open network file '" << networkFile << "'.");
+
+	string line;
+	size_t lineNumber = 0;
+	while (getline(in, line)) {
+		lineNumber++;
+		istringstream ss(line);
+		string filename;
+		if (!(ss >> filename) || filename[0] == '#') continue;
+
+		std::vector<number> transform;
+		number value;
+		while (ss >> value) {
+			transform.push_back(value);
+		}
+		UG_COND_THROW(!ss.eof(), "Invalid transform in line " << lineNumber << " of network file '" << networkFile << "'.");
+		add_network_cell(filename, transform);
+	}
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "read " << m_networkCells.size() << " cells from network file '" << networkFile << "'");
+}
+
+void Neurolucida::assemble_network(size_t numThreads) {
+	UG_COND_THROW(m_networkCells.empty(), "The network has no cells.");
+	clear_document();
+
+	ThreadPool pool(numThreads);
+	/// cells are converted in chunks, thus only the grids of one chunk are kept at a time
+	const size_t chunkSize = 2 * pool.num_threads();
+	for (size_t first = 0; first < m_networkCells.size(); first += chunkSize) {
+		size_t count = std::min(chunkSize, m_networkCells.size() - first);
+		std::vector<Neurolucida*> converters(count, NULL);
+		try {
+			ParallelFor(pool, count, [this, first, &converters](size_t i) {
+				converters[i] = create_converter();
+				converters[i]->convert_in_memory(m_networkCells[first+i].filename);
+			});
+
+			/// appended in order, independent of the order the cells were converted in
+			for (size_t i = 0; i < count; i++) {
+				append_cell(*converters[i], m_networkCells[first+i], first+i);
+				destroy_converter(converters[i]);
+				converters[i] = NULL;
+			}
+		} catch (...) {
+			for (size_t i = 0; i < count; i++) {
+				if (converters[i]) destroy_converter(converters[i]);
+			}
+			throw;
+		}
+	}
+	m_bNetworkAssembled = true;
+
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "assembled network of " << m_networkCells.size() << " cells with " << m_g->num_vertices()
+					 << " vertices, " << m_g->num_edges() << " edges and " << m_s->num_subsets() << " subsets");
+}
+
+void Neurolucida::append_cell(Neurolucida& cell, NetworkCell& networkCell, size_t cellIndex) {
+	const number* t = networkCell.transform;
+	number det = t[0] * (t[5] * t[10] - t[6] * t[9])
+			   - t[1] * (t[4] * t[10] - t[6] * t[8])
+			   + t[2] * (t[4] * t[9] - t[5] * t[8]);
+	const number diameterScale = std::cbrt(std::abs(det));
+
+	const int subsetOffset = m_s->num_subsets();
+	ug::AVertex aCopy;
+	cell.m_g->attach_to_vertices(aCopy);
+	ug::Grid::VertexAttachmentAccessor<ug::AVertex> aaCopy(*cell.m_g, aCopy);
+
+	for (ug::VertexIterator it = cell.m_g->begin<ug::Vertex>(); it != cell.m_g->end<ug::Vertex>(); ++it) {
+		ug::Vertex* vtx = *m_g->create<ug::RegularVertex>();
+		/// the translation is given in the units of the file, positions are scaled already
+		const ug::vector3& p = cell.m_aaPos[*it];
+		ug::vector3& q = m_aaPos[vtx];
+		for (size_t r = 0; r < 3; r++) {
+			q[r] = t[4*r] * p[0] + t[4*r+1] * p[1] + t[4*r+2] * p[2] + t[4*r+3] * cell.m_scaling;
+		}
+		m_aaDiameter[vtx] = cell.m_aaDiameter[*it] * diameterScale;
+		aaCopy[*it] = vtx;
+		int si = cell.m_s->get_subset_index(*it);
+		if (si >= 0) m_s->assign_subset(vtx, si + subsetOffset);
+	}
+
+	for (ug::EdgeIterator it = cell.m_g->begin<ug::Edge>(); it != cell.m_g->end<ug::Edge>(); ++it) {
+		ug::Edge* edge = *m_g->create<ug::RegularEdge>(ug::EdgeDescriptor(aaCopy[(*it)->vertex(0)], aaCopy[(*it)->vertex(1)]));
+		int si = cell.m_s->get_subset_index(*it);
+		if (si >= 0) m_s->assign_subset(edge, si + subsetOffset);
+	}
+
+	for (int si = 0; si < cell.m_s->num_subsets(); si++) {
+		stringstream ss;
+		ss << "Cell" << cellIndex + 1 << "_" << cell.m_s->subset_info(si).name;
+		m_s->subset_info(si + subsetOffset) = cell.m_s->subset_info(si);
+		m_s->subset_info(si + subsetOffset).name = ss.str();
+	}
+
+	cell.m_g->detach_from_vertices(aCopy);
+	networkCell.firstSubset = subsetOffset;
+	networkCell.numSubsets = cell.m_s->num_subsets();
+	networkCell.numVertices = cell.m_g->num_vertices();
+	NEUROLUCIDA_LOGN(LOG_ELEMENTS, "appended cell '" << networkCell.filename << "' with " << networkCell.numVertices << " vertices");
+}
+
+void Neurolucida::compute_partitions(int partitioning, size_t numPartitions) {
+	UG_COND_THROW(numPartitions == 0, "At least one partition is required.");
+	m_partitions.reset(new ug::SubsetHandler(*m_g));
+
+	if (partitioning == PARTITION_CELLS) {
+		UG_COND_THROW(!m_bNetworkAssembled, "Partitioning by cells requires an assembled network.");
+
+		/// largest cells first, each to the partition with the fewest vertices so far
+		std::vector<size_t> order(m_networkCells.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+			return m_networkCells[a].numVertices > m_networkCells[b].numVertices;
+		});
+		std::vector<size_t> load(numPartitions, 0);
+		std::vector<int> partitionOfSubset(m_s->num_subsets(), 0);
+		for (size_t i = 0; i < order.size(); i++) {
+			const NetworkCell& cell = m_networkCells[order[i]];
+			int p = static_cast<int>(std::min_element(load.begin(), load.end()) - load.begin());
+			load[p] += cell.numVertices;
+			for (int si = cell.firstSubset; si < cell.firstSubset + cell.numSubsets; si++) {
+				partitionOfSubset[si] = p;
+			}
+		}
+
+		for (ug::VertexIterator it = m_g->begin<ug::Vertex>(); it != m_g->end<ug::Vertex>(); ++it) {
+			int si = m_s->get_subset_index(*it);
+			m_partitions->assign_subset(*it, si >= 0 ? partitionOfSubset[si] : 0);
+		}
+		for (ug::EdgeIterator it = m_g->begin<ug::Edge>(); it != m_g->end<ug::Edge>(); ++it) {
+			int si = m_s->get_subset_index(*it);
+			m_partitions->assign_subset(*it, si >= 0 ? partitionOfSubset[si] : 0);
+		}
+	} else if (partitioning == PARTITION_SPATIAL) {
+		std::vector<ug::Edge*> edges;
+		std::vector<ug::vector3> centers;
+		edges.reserve(m_g->num_edges());
+		centers.reserve(m_g->num_edges());
+		for (ug::EdgeIterator it = m_g->begin<ug::Edge>(); it != m_g->end<ug::Edge>(); ++it) {
+			ug::vector3 center;
+			VecScaleAdd(center, 0.5, m_aaPos[(*it)->vertex(0)], 0.5, m_aaPos[(*it)->vertex(1)]);
+			edges.push_back(*it);
+			centers.push_back(center);
+		}
+
+		std::vector<size_t> order(edges.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+		std::vector<int> part(edges.size(), 0);
+		Bisect(order.begin(), order.end(), centers, numPartitions, 0, part);
+
+		/// vertices belong to the partition of the first edge containing them
+		for (ug::VertexIterator it = m_g->begin<ug::Vertex>(); it != m_g->end<ug::Vertex>(); ++it) {
+			m_partitions->assign_subset(*it, -1);
+		}
+		for (size_t i = 0; i < edges.size(); i++) {
+			m_partitions->assign_subset(edges[i], part[i]);
+			for (size_t j = 0; j < 2; j++) {
+				ug::Vertex* vrt = edges[i]->vertex(j);
+				if (m_partitions->get_subset_index(vrt) < 0) m_partitions->assign_subset(vrt, part[i]);
+			}
+		}
+		for (ug::VertexIterator it = m_g->begin<ug::Vertex>(); it != m_g->end<ug::Vertex>(); ++it) {
+			if (m_partitions->get_subset_index(*it) < 0) m_partitions->assign_subset(*it, 0);
+		}
+	} else {
+		m_partitions.reset();
+		UG_THROW("Unknown partitioning '" << partitioning << "'.");
+	}
+
+	for (size_t p = 0; p < numPartitions; p++) {
+		stringstream ss;
+		ss << "Partition_" << p;
+		m_partitions->subset_info(static_cast<int>(p)).name = ss.str();
+	}
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "computed " << numPartitions << " partitions ("
+					 << (partitioning == PARTITION_CELLS ? "cells" : "spatial") << ")");
+}
+
+void Neurolucida::save_network(const std::string& filename) {
+	ug::GridWriterUGX writer;
+	writer.add_grid(*m_g, "defGrid", ug::aPosition);
+	writer.add_subset_handler(*m_s, "defSH", 0);
+	if (m_partitions) writer.add_subset_handler(*m_partitions, "partitions", 0);
+	UG_COND_THROW(!writer.write_to_file(filename.c_str()), "Could not write file '" << filename << "'.");
+	NEUROLUCIDA_LOGN(LOG_SUMMARY, "written network '" << filename << "'");
+}
+
+void Neurolucida::convert_network(const std::string& networkFile, const std::string& outputFile,
+								  int partitioning, size_t numPartitions, size_t numThreads) {
+	clear_network();
+	read_network(networkFile);
+	assemble_network(numThreads);
+	compute_partitions(partitioning, numPartitions);
+	save_network(outputFile);
+}
+
+void Neurolucida::copy_partitions(ug::Domain3d& dom, ug::ISubsetHandler& partitions) {
+	UG_COND_THROW(!m_partitions, "No partitions computed.");
+	ug::MultiGrid& mg = *dom.grid();
+	UG_COND_THROW(mg.num<ug::Vertex>() != m_g->num<ug::Vertex>() || mg.num<ug::Edge>() != m_g->num<ug::Edge>(),
+				  "The domain does not contain a copy of the grid.");
+
+	ug::VertexIterator domIt = mg.begin<ug::Vertex>();
+	for (ug::VertexIterator it = m_g->begin<ug::Vertex>(); it != m_g->end<ug::Vertex>(); ++it, ++domIt) {
+		partitions.assign_subset(*domIt, m_partitions->get_subset_index(*it));
+	}
+	ug::EdgeIterator domEdgeIt = mg.begin<ug::Edge>();
+	for (ug::EdgeIterator it = m_g->begin<ug::Edge>(); it != m_g->end<ug::Edge>(); ++it, ++domEdgeIt) {
+		partitions.assign_subset(*domEdgeIt, m_partitions->get_subset_index(*it));
+	}
+	for (int p = 0; p < m_partitions->num_subsets(); p++) {
+		partitions.subset_info(p).name = m_partitions->subset_info(p).name;
+	}
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_output_sink.cpp
+ * \brief output formats written from one traversal of the finished grid
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_output_sink.h"
+#include "neurolucida_ugx_writer.h"
+
+#include <limits>
+
+using namespace ug::neurolucida;
+using namespace std;
+
+bool UGXSink::write(const OutputGeometry& geometry, const std::string& filename, int compression) const {
+	/// no vertex is merged, thus the threshold is not used
+	UGXStreamWriter writer(0);
+	if (!writer.open(filename, compression)) return false;
+
+	for (size_t si = 0; si < geometry.subsetNames.size(); si++) {
+		writer.set_subset_info(static_cast<int>(si), geometry.subsetNames[si], geometry.subsetColors[si]);
+	}
+
+	/// vertices and edges of the grid are distinct, thus vertex i is written as vertex i
+	for (size_t i = 0; i < geometry.positions.size(); i++) {
+		writer.add_vertex(geometry.positions[i], geometry.diameters[i], geometry.vertexSubsets[i]);
+	}
+
+	for (size_t i = 0; i < geometry.edges.size(); i++) {
+		writer.add_edge(geometry.edges[i].first, geometry.edges[i].second, geometry.edgeSubsets[i]);
+	}
+
+	return writer.close();
+}
+
+bool OBJSink::write(const OutputGeometry& geometry, const std::string& filename, int compression) const {
+	OutputFile out;
+	if (!out.open(filename, compression)) return false;
+	out.precision(numeric_limits<double>::digits10 + 2);
+
+	for (size_t i = 0; i < geometry.positions.size(); i++) {
+		const ug::vector3& pos = geometry.positions[i];
+		out << "v " << pos[0] << ' ' << pos[1] << ' ' << pos[2] << '\n';
+	}
+
+	/// edges grouped by subset, edges without subset are written last
+	const size_t numSubsets = geometry.subsetNames.size();
+	std::vector<std::vector<size_t> > edgesOfSubset(numSubsets + 1);
+	for (size_t i = 0; i < geometry.edges.size(); i++) {
+		int si = geometry.edgeSubsets[i];
+		edgesOfSubset[si >= 0 ? static_cast<size_t>(si) : numSubsets].push_back(i);
+	}
+
+	for (size_t si = 0; si <= numSubsets; si++) {
+		const std::vector<size_t>& edges = edgesOfSubset[si];
+		if (edges.empty()) continue;
+		out << "o " << (si < numSubsets ? geometry.subsetNames[si] : "unassigned") << '\n';
+		for (size_t i = 0; i < edges.size(); i++) {
+			/// OBJ indices start at 1
+			out << "l " << geometry.edges[edges[i]].first + 1 << ' ' << geometry.edges[edges[i]].second + 1 << '\n';
+		}
+	}
+
+	return out.close();
+}
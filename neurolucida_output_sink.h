@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_output_sink.h
+ * \brief output formats written from one traversal of the finished grid
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_OUTPUT_SINK__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_OUTPUT_SINK__
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <common/math/ugmath.h>
+
+#include "neurolucida_compression.h"
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief vertices, edges and subsets of the finished grid
+		 * Elements are numbered consecutively, edges refer to vertex indices.
+		 */
+		struct OutputGeometry {
+			std::vector<ug::vector3> positions;
+			std::vector<number> diameters;
+			std::vector<int> vertexSubsets; ///<! -1 for none
+			std::vector<std::pair<size_t, size_t> > edges;
+			std::vector<int> edgeSubsets; ///<! -1 for none
+			std::vector<std::string> subsetNames;
+			std::vector<ug::MathVector<4> > subsetColors;
+
+			void clear() {
+				positions.clear();
+				diameters.clear();
+				vertexSubsets.clear();
+				edges.clear();
+				edgeSubsets.clear();
+				subsetNames.clear();
+				subsetColors.clear();
+			}
+		};
+
+		/*!
+		 * \brief an output format
+		 * All sinks of a conversion are given the same geometry and write it
+		 * concurrently, each on its own thread. A sink may be shared by
+		 * converters running in parallel, thus write must not modify the sink.
+		 */
+		class OutputSink {
+		public:
+			virtual ~OutputSink() {}
+
+			/*!
+			 * \brief extension of the files written, e.g. ".ugx"
+			 */
+			virtual std::string extension() const = 0;
+
+			/*!
+			 * \brief writes the geometry to the file
+			 * \param[in] compression one of Compression, the file is compressed while written
+			 * \return false if the file could not be written completely
+			 */
+			virtual bool write(const OutputGeometry& geometry, const std::string& filename, int compression) const = 0;
+		};
+
+		/*!
+		 * \brief UGX as written by SaveGridToFile, with the diameter attachment and the subsets
+		 */
+		class UGXSink : public OutputSink {
+		public:
+			virtual std::string extension() const {
+				return ".ugx";
+			}
+
+			virtual bool write(const OutputGeometry& geometry, const std::string& filename, int compression) const;
+		};
+
+		/*!
+		 * \brief Wavefront OBJ, edges are written as line elements of one object per subset
+		 */
+		class OBJSink : public OutputSink {
+		public:
+			virtual std::string extension() const {
+				return ".obj";
+			}
+
+			virtual bool write(const OutputGeometry& geometry, const std::string& filename, int compression) const;
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_OUTPUT_SINK__
@@ -60,17 +60,69 @@ namespace ug {
 	namespace neurolucida {
 		struct Functionality {
 			static void Common(Registry& reg, string grp) {
+				reg.add_class_<Statistics>("NeurolucidaStatistics", "Neuro/")
+					.add_method("get_phase_time", (double (Statistics::*)(const std::string&) const)&Statistics::get_phase_time)
+					.add_method("get_counter", (size_t (Statistics::*)(const std::string&) const)&Statistics::get_counter)
+					.add_method("get_json", (std::string (Statistics::*)() const)&Statistics::get_json)
+					.add_method("print", (void (Statistics::*)() const)&Statistics::print);
+
 				typedef neurolucida::Neurolucida TNeurolucida;
 				reg.add_class_<TNeurolucida>("Neurolucida", "Neuro/")
 					.add_constructor<void (*)()>("")
 					.add_method("convert", (void (TNeurolucida::*)(const std::string&))&TNeurolucida::convert)
 					.add_method("convert", (void (TNeurolucida::*)(const std::string&, bool, bool))&TNeurolucida::convert)
+					.add_method("convert_in_memory", (void (TNeurolucida::*)(const std::string&))&TNeurolucida::convert_in_memory)
+					.add_method("convert_to_domain", (SmartPtr<Domain3d> (TNeurolucida::*)(const std::string&))&TNeurolucida::convert_to_domain)
+					.add_method("copy_to_domain", (void (TNeurolucida::*)(Domain3d&))&TNeurolucida::copy_to_domain)
+					.add_method("grid", (ug::Grid& (TNeurolucida::*)())&TNeurolucida::grid)
+					.add_method("subset_handler", (ug::SubsetHandler& (TNeurolucida::*)())&TNeurolucida::subset_handler)
+					.add_method("save_grid", (void (TNeurolucida::*)(const std::string&))&TNeurolucida::save_grid)
 					.add_method("set_separator", (void (TNeurolucida::*)(const std::string&))&TNeurolucida::set_separator)
 					.add_method("set_scaling", (void (TNeurolucida::*)(number))&TNeurolucida::set_scaling)
 					.add_method("set_VRLOutputNames", (void (TNeurolucida::*)(bool))&TNeurolucida::set_VRLOutputNames)
+					.add_method("convert_batch", (size_t (TNeurolucida::*)(const std::string&, size_t))&TNeurolucida::convert_batch)
+					.add_method("convert_batch", (size_t (TNeurolucida::*)(const std::vector<std::string>&, size_t))&TNeurolucida::convert_batch)
+					.add_method("print_batch_report", (void (TNeurolucida::*)())&TNeurolucida::print_batch_report)
+					.add_method("convert_distributed", (size_t (TNeurolucida::*)(const std::string&))&TNeurolucida::convert_distributed)
+					.add_method("convert_distributed", (size_t (TNeurolucida::*)(const std::vector<std::string>&))&TNeurolucida::convert_distributed)
+					.add_method("add_network_cell", (void (TNeurolucida::*)(const std::string&, const std::vector<number>&))&TNeurolucida::add_network_cell)
+					.add_method("add_network_cell", (void (TNeurolucida::*)(const std::string&))&TNeurolucida::add_network_cell)
+					.add_method("read_network", (void (TNeurolucida::*)(const std::string&))&TNeurolucida::read_network)
+					.add_method("clear_network", (void (TNeurolucida::*)())&TNeurolucida::clear_network)
+					.add_method("assemble_network", (void (TNeurolucida::*)(size_t))&TNeurolucida::assemble_network)
+					.add_method("compute_partitions", (void (TNeurolucida::*)(int, size_t))&TNeurolucida::compute_partitions)
+					.add_method("save_network", (void (TNeurolucida::*)(const std::string&))&TNeurolucida::save_network)
+					.add_method("convert_network", (void (TNeurolucida::*)(const std::string&, const std::string&, int, size_t, size_t))&TNeurolucida::convert_network)
+					.add_method("copy_partitions", (void (TNeurolucida::*)(Domain3d&, ISubsetHandler&))&TNeurolucida::copy_partitions)
+					.add_method("find_appositions", (size_t (TNeurolucida::*)(number, size_t))&TNeurolucida::find_appositions)
+					.add_method("write_appositions", (void (TNeurolucida::*)(const std::string&) const)&TNeurolucida::write_appositions)
+					.add_method("get_num_appositions", (size_t (TNeurolucida::*)() const)&TNeurolucida::get_num_appositions)
+					.add_method("set_log_level", (void (TNeurolucida::*)(int))&TNeurolucida::set_log_level)
+					.add_method("set_soma_attachment", (void (TNeurolucida::*)(int))&TNeurolucida::set_soma_attachment)
+					.add_method("set_num_threads", (void (TNeurolucida::*)(size_t))&TNeurolucida::set_num_threads)
+					.add_method("set_streaming", (void (TNeurolucida::*)(bool))&TNeurolucida::set_streaming)
+					.add_method("set_memory_mapped", (void (TNeurolucida::*)(bool))&TNeurolucida::set_memory_mapped)
+					.add_method("set_streaming_output", (void (TNeurolucida::*)(bool))&TNeurolucida::set_streaming_output)
+					.add_method("set_cache_directory", (void (TNeurolucida::*)(const std::string&))&TNeurolucida::set_cache_directory)
+					.add_method("set_simplification", (void (TNeurolucida::*)(number, number))&TNeurolucida::set_simplification)
+					.add_method("get_num_simplified_points", (size_t (TNeurolucida::*)() const)&TNeurolucida::get_num_simplified_points)
+					.add_method("set_compression", (void (TNeurolucida::*)(int))&TNeurolucida::set_compression)
+					.add_method("set_morphometrics_output", (void (TNeurolucida::*)(int))&TNeurolucida::set_morphometrics_output)
+					.add_method("set_sholl_step", (void (TNeurolucida::*)(number))&TNeurolucida::set_sholl_step)
+					.add_method("get_total_length", (number (TNeurolucida::*)() const)&TNeurolucida::get_total_length)
+					.add_method("get_surface_area", (number (TNeurolucida::*)() const)&TNeurolucida::get_surface_area)
+					.add_method("get_volume", (number (TNeurolucida::*)() const)&TNeurolucida::get_volume)
+					.add_method("set_statistics_output", (void (TNeurolucida::*)(bool))&TNeurolucida::set_statistics_output)
+					.add_method("get_statistics", (const Statistics& (TNeurolucida::*)() const)&TNeurolucida::get_statistics)
+					.add_method("print_statistics", (void (TNeurolucida::*)() const)&TNeurolucida::print_statistics)
+					.add_method("set_surface_output", (void (TNeurolucida::*)(int))&TNeurolucida::set_surface_output)
+					.add_method("set_surface_resolution", (void (TNeurolucida::*)(size_t))&TNeurolucida::set_surface_resolution)
+					.add_method("release_input", (void (TNeurolucida::*)())&TNeurolucida::release_input)
+					.add_method("reset", (void (TNeurolucida::*)())&TNeurolucida::reset)
 					.add_method("print_setup",  (void (TNeurolucida::*)())&TNeurolucida::print_setup)
 					.add_method("set_obj_output", (void (TNeurolucida::*)(bool))&TNeurolucida::set_convert_to_obj)
-					.add_method("set_ugx_output", (void (TNeurolucida::*)(bool))&TNeurolucida::set_convert_to_ugx);
+					.add_method("set_ugx_output", (void (TNeurolucida::*)(bool))&TNeurolucida::set_convert_to_ugx)
+					.add_method("set_swc_output", (void (TNeurolucida::*)(bool))&TNeurolucida::set_convert_to_swc);
 			}
 		};
 	} /// \}
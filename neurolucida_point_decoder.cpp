@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_point_decoder.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_point_decoder.h"
+
+#include <locale>
+#include <sstream>
+
+#include "common/error.h"
+
+using namespace std;
+
+namespace ug {
+	namespace neurolucida {
+		namespace {
+			/// powers of ten exactly representable as double
+			const double EXACT_POWERS_OF_TEN[] = {
+				1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+			};
+
+			const unsigned long long MAX_EXACT_MANTISSA = 1ULL << 53;
+
+			inline bool is_space(char c) {
+				return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+			}
+
+			inline bool is_digit(char c) {
+				return c >= '0' && c <= '9';
+			}
+
+			/*!
+			 * \brief correctly rounded conversion for all other numbers
+			 */
+			bool parse_number_slow(const char* begin, const char* end, number& value) {
+				istringstream in(string(begin, end));
+				in.imbue(locale::classic());
+				double result;
+				in >> result;
+				if (in.fail()) return false;
+				in >> ws;
+				if (!in.eof()) return false;
+				value = result;
+				return true;
+			}
+
+			/// point coordinates and diameter in the order of MathVector<4>
+			int coordinate_index(const char* name, size_t nameSize) {
+				if (nameSize != 1) return -1;
+				switch (name[0]) {
+					case 'x': return 0;
+					case 'y': return 1;
+					case 'z': return 2;
+					case 'd': return 3;
+					default: return -1;
+				}
+			}
+
+			const char* COORDINATE_NAMES[] = {"x", "y", "z", "d"};
+
+			void check_complete(int found) {
+				for (int i = 0; i < 4; i++) {
+					UG_COND_THROW(!(found & (1 << i)), "Point without attribute '" << COORDINATE_NAMES[i] << "' found.");
+				}
+			}
+		}
+
+		bool ParseNumber(const char* begin, const char* end, number& value) {
+			const char* p = begin;
+			while (p != end && is_space(*p)) p++;
+			while (end != p && is_space(*(end-1))) end--;
+			if (p == end) return false;
+
+			const char* start = p;
+			bool negative = false;
+			if (*p == '-' || *p == '+') {
+				negative = (*p == '-');
+				p++;
+			}
+
+			/// accumulate up to 19 significant digits, leading zeros do not count
+			unsigned long long mantissa = 0;
+			int numDigits = 0;
+			int exponent = 0;
+			bool anyDigit = false;
+			bool truncated = false;
+			for (; p != end && is_digit(*p); p++) {
+				anyDigit = true;
+				if (mantissa == 0 && *p == '0') continue;
+				if (numDigits < 19) {
+					mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+					numDigits++;
+				} else {
+					truncated = true;
+				}
+			}
+
+			if (p != end && *p == '.') {
+				p++;
+				for (; p != end && is_digit(*p); p++) {
+					anyDigit = true;
+					if (mantissa == 0 && *p == '0') {
+						exponent--;
+						continue;
+					}
+					if (numDigits < 19) {
+						mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+						numDigits++;
+						exponent--;
+					} else {
+						truncated = true;
+					}
+				}
+			}
+
+			if (!anyDigit) return parse_number_slow(start, end, value);
+
+			if (p != end && (*p == 'e' || *p == 'E')) {
+				p++;
+				bool negativeExponent = false;
+				if (p != end && (*p == '-' || *p == '+')) {
+					negativeExponent = (*p == '-');
+					p++;
+				}
+				if (p == end || !is_digit(*p)) return false;
+				int e = 0;
+				for (; p != end && is_digit(*p); p++) {
+					if (e < 10000) e = e * 10 + (*p - '0');
+				}
+				exponent += negativeExponent ? -e : e;
+			}
+
+			if (p != end) return false;
+
+			if (truncated || mantissa > MAX_EXACT_MANTISSA || exponent < -22 || exponent > 22) {
+				return parse_number_slow(start, end, value);
+			}
+
+			double result = static_cast<double>(mantissa);
+			if (exponent < 0) {
+				result /= EXACT_POWERS_OF_TEN[-exponent];
+			} else {
+				result *= EXACT_POWERS_OF_TEN[exponent];
+			}
+			value = negative ? -result : result;
+			return true;
+		}
+
+		void DecodePoint(const rapidxml::xml_node<>* node, MathVector<4>& point) {
+			int found = 0;
+			for (const rapidxml::xml_attribute<>* attribute = node->first_attribute(); attribute; attribute = attribute->next_attribute()) {
+				int i = coordinate_index(attribute->name(), attribute->name_size());
+				if (i < 0 || (found & (1 << i))) continue;
+				const char* value = attribute->value();
+				UG_COND_THROW(!ParseNumber(value, value + attribute->value_size(), point.coord(i)),
+							  "Point with malformed attribute " << COORDINATE_NAMES[i] << "='" << string(value, attribute->value_size()) << "' found.");
+				found |= 1 << i;
+			}
+			check_complete(found);
+		}
+
+		void DecodePoint(const XMLStreamReader& reader, MathVector<4>& point) {
+			int found = 0;
+			for (size_t a = 0; a < reader.num_attributes(); a++) {
+				const string& name = reader.attribute_name(a);
+				int i = coordinate_index(name.c_str(), name.size());
+				if (i < 0 || (found & (1 << i))) continue;
+				const string& value = reader.attribute_value(a);
+				UG_COND_THROW(!ParseNumber(value.c_str(), value.c_str() + value.size(), point.coord(i)),
+							  "Point with malformed attribute " << COORDINATE_NAMES[i] << "='" << value << "' found.");
+				found |= 1 << i;
+			}
+			check_complete(found);
+		}
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_point_decoder.h
+ * \brief decoding of Neurolucida point tags
+ *
+ * A point tag (<point x=".." y=".." z=".." d=".."/>) is decoded by a single
+ * pass over its attributes instead of one name lookup per coordinate. Numbers
+ * are parsed locale independently: decimal numbers with at most 19 significant
+ * digits and a small exponent are converted exactly by a single multiplication
+ * or division (Clinger's fast path), all other numbers are handed to the
+ * classic "C" locale stream conversion. Both are correctly rounded and hence
+ * give the same results as atof in the "C" locale. Numbers out of the
+ * range of double are rejected.
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_POINT_DECODER__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_POINT_DECODER__
+
+#include <string>
+
+#include <common/parser/rapidxml/rapidxml.hpp>
+#include <common/math/ugmath.h>
+
+#include "neurolucida_stream_reader.h"
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief parses a decimal floating point number
+		 * Leading and trailing whitespace is ignored, anything else not being part
+		 * of the number makes the parse fail.
+		 * \param[in] begin first character
+		 * \param[in] end one past the last character
+		 * \param[out] value parsed number
+		 * \return false if the characters do not form a number
+		 */
+		bool ParseNumber(const char* begin, const char* end, number& value);
+
+		/*!
+		 * \brief decodes the coordinates and diameter of a point tag of the DOM
+		 * Throws if an attribute is missing or not a number.
+		 */
+		void DecodePoint(const rapidxml::xml_node<>* node, MathVector<4>& point);
+
+		/*!
+		 * \brief decodes the coordinates and diameter of the current point tag of the stream
+		 * Throws if an attribute is missing or not a number.
+		 */
+		void DecodePoint(const XMLStreamReader& reader, MathVector<4>& point);
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_POINT_DECODER__
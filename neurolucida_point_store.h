@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_point_store.h
+ * \brief points of a contour or tree as separate coordinate arrays
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_POINT_STORE__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_POINT_STORE__
+
+#include <vector>
+
+#include <common/math/ugmath.h>
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief stores x, y, z and diameter of points in separate arrays
+		 * The scalar type is a template parameter, thus large reconstructions may
+		 * be stored in single precision. Whole arrays are processed at once, e.g.
+		 * scaled, which the compiler vectorizes.
+		 */
+		template <typename TScalar>
+		class PointStore {
+		public:
+			typedef TScalar scalar_type;
+
+			inline size_t size() const {
+				return m_x.size();
+			}
+
+			inline bool empty() const {
+				return m_x.empty();
+			}
+
+			/*!
+			 * \brief removes all points, the capacity is kept
+			 */
+			void clear() {
+				m_x.clear();
+				m_y.clear();
+				m_z.clear();
+				m_d.clear();
+			}
+
+			void reserve(size_t n) {
+				m_x.reserve(n);
+				m_y.reserve(n);
+				m_z.reserve(n);
+				m_d.reserve(n);
+			}
+
+			/*!
+			 * \brief appends a point given as x, y, z and diameter
+			 */
+			void push_back(const MathVector<4>& point) {
+				m_x.push_back(static_cast<TScalar>(point[0]));
+				m_y.push_back(static_cast<TScalar>(point[1]));
+				m_z.push_back(static_cast<TScalar>(point[2]));
+				m_d.push_back(static_cast<TScalar>(point[3]));
+			}
+
+			/*!
+			 * \brief replaces all points by n points given as separate arrays
+			 */
+			template <typename TSource>
+			void assign(const TSource* x, const TSource* y, const TSource* z, const TSource* d, size_t n) {
+				m_x.assign(x, x + n);
+				m_y.assign(y, y + n);
+				m_z.assign(z, z + n);
+				m_d.assign(d, d + n);
+			}
+
+			/*!
+			 * \brief removes all points i with keep[i] == 0, keeping the order of the others
+			 */
+			void remove_unkept(const std::vector<char>& keep) {
+				remove_unkept(m_x, keep);
+				remove_unkept(m_y, keep);
+				remove_unkept(m_z, keep);
+				remove_unkept(m_d, keep);
+			}
+
+			/*!
+			 * \brief point i as x, y, z and diameter
+			 */
+			inline MathVector<4> operator[](size_t i) const {
+				return MathVector<4>(m_x[i], m_y[i], m_z[i], m_d[i]);
+			}
+
+			inline ug::vector3 position(size_t i) const {
+				return ug::vector3(m_x[i], m_y[i], m_z[i]);
+			}
+
+			inline number diameter(size_t i) const {
+				return m_d[i];
+			}
+
+			/*!
+			 * \brief multiplies coordinates and diameters of all points by the factor
+			 */
+			void scale(number factor) {
+				scale(m_x, factor);
+				scale(m_y, factor);
+				scale(m_z, factor);
+				scale(m_d, factor);
+			}
+
+			inline const std::vector<TScalar>& x() const {
+				return m_x;
+			}
+
+			inline const std::vector<TScalar>& y() const {
+				return m_y;
+			}
+
+			inline const std::vector<TScalar>& z() const {
+				return m_z;
+			}
+
+			inline const std::vector<TScalar>& d() const {
+				return m_d;
+			}
+
+		private:
+			static void remove_unkept(std::vector<TScalar>& values, const std::vector<char>& keep) {
+				size_t n = 0;
+				for (size_t i = 0; i < values.size(); i++) {
+					if (keep[i]) values[n++] = values[i];
+				}
+				values.resize(n);
+			}
+
+			static void scale(std::vector<TScalar>& values, number factor) {
+				const TScalar f = static_cast<TScalar>(factor);
+				TScalar* v = values.empty() ? NULL : &values[0];
+				const size_t n = values.size();
+				for (size_t i = 0; i < n; i++) {
+					v[i] *= f;
+				}
+			}
+
+		private:
+			std::vector<TScalar> m_x;
+			std::vector<TScalar> m_y;
+			std::vector<TScalar> m_z;
+			std::vector<TScalar> m_d;
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_POINT_STORE__
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_simplification.cpp
+ * \brief Douglas-Peucker simplification of the branches of trees
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	/*!
+	 * \brief error of a point relative to its tolerance, greater than 1 if the tolerance is exceeded
+	 */
+	inline number relative_error(number error, number tolerance) {
+		if (tolerance > 0) return error / tolerance;
+		return error > 0 ? numeric_limits<number>::max() : 0;
+	}
+}
+
+size_t Neurolucida::simplify_trees(Tree* trees, size_t numTrees) {
+	std::vector<Branch> branches;
+	std::vector<std::vector<char> > keep(numTrees);
+	for (size_t i = 0; i < numTrees; i++) {
+		keep[i].assign(trees[i].points.size(), 1);
+		collect_branches(trees[i], i, branches);
+	}
+
+	/// inner points belong to exactly one branch, thus branches are simplified independently
+	parallel_for(branches.size(), [this, trees, &branches, &keep](size_t b) {
+		simplify_branch(trees[branches[b].tree].points, branches[b].points, keep[branches[b].tree]);
+	});
+
+	std::vector<size_t> removed(numTrees, 0);
+	parallel_for(numTrees, [this, trees, &keep, &removed](size_t i) {
+		removed[i] = remove_points(trees[i], keep[i]);
+	});
+
+	size_t numRemoved = 0;
+	for (size_t i = 0; i < numTrees; i++) {
+		numRemoved += removed[i];
+	}
+	NEUROLUCIDA_LOGN(LOG_ELEMENTS, "simplified " << branches.size() << " branches, removed " << numRemoved << " points");
+	return numRemoved;
+}
+
+void Neurolucida::collect_branches(const Tree& t, size_t treeIndex, std::vector<Branch>& branches) const {
+	const size_t numPoints = t.points.size();
+	if (t.edges.empty()) return;
+
+	/// outgoing edges as adjacency lists, inner points of branches have one incoming and one outgoing edge
+	std::vector<size_t> numIn(numPoints, 0);
+	std::vector<size_t> numOut(numPoints, 0);
+	std::vector<CEdge>::const_iterator it = t.edges.begin();
+	for (; it != t.edges.end(); ++it) {
+		numIn[it->to]++;
+		numOut[it->from]++;
+	}
+
+	std::vector<size_t> firstOut(numPoints + 1, 0);
+	for (size_t i = 0; i < numPoints; i++) {
+		firstOut[i+1] = firstOut[i] + numOut[i];
+	}
+	std::vector<size_t> out(t.edges.size());
+	std::vector<size_t> fill(firstOut.begin(), firstOut.end() - 1);
+	for (it = t.edges.begin(); it != t.edges.end(); ++it) {
+		out[fill[it->from]++] = it->to;
+	}
+
+	std::vector<char> inner(numPoints, 0);
+	for (size_t i = 0; i < numPoints; i++) {
+		inner[i] = numIn[i] == 1 && numOut[i] == 1;
+	}
+	/// the root is attached to the soma
+	inner[t.edges.front().from] = 0;
+
+	for (size_t i = 0; i < numPoints; i++) {
+		if (inner[i]) continue;
+		for (size_t e = firstOut[i]; e < firstOut[i+1]; e++) {
+			size_t next = out[e];
+			if (!inner[next]) continue;
+
+			Branch branch;
+			branch.tree = treeIndex;
+			branch.points.push_back(i);
+			/// inner points have a single incoming edge, thus the walk ends at a point which is not inner
+			while (inner[next]) {
+				branch.points.push_back(next);
+				next = out[firstOut[next]];
+			}
+			branch.points.push_back(next);
+			branches.push_back(branch);
+		}
+	}
+}
+
+void Neurolucida::simplify_branch(const Points& points, const std::vector<size_t>& branch, std::vector<char>& keep) const {
+	for (size_t i = 1; i + 1 < branch.size(); i++) {
+		keep[branch[i]] = 0;
+	}
+
+	/// ranges of the branch still to be approximated, processed without recursion
+	std::vector<std::pair<size_t, size_t> > ranges;
+	ranges.push_back(std::make_pair(0, branch.size() - 1));
+	while (!ranges.empty()) {
+		size_t first = ranges.back().first;
+		size_t last = ranges.back().second;
+		ranges.pop_back();
+		if (last - first < 2) continue;
+
+		const ug::vector3 a = points.position(branch[first]);
+		const ug::vector3 b = points.position(branch[last]);
+		const number da = points.diameter(branch[first]);
+		const number db = points.diameter(branch[last]);
+		ug::vector3 ab;
+		VecSubtract(ab, b, a);
+		const number lengthSq = VecLengthSq(ab);
+
+		number maxError = 0;
+		size_t maxIndex = first;
+		for (size_t i = first + 1; i < last; i++) {
+			const ug::vector3 p = points.position(branch[i]);
+			ug::vector3 ap;
+			VecSubtract(ap, p, a);
+
+			/// closest point on the segment, the diameter is interpolated the same way
+			number s = lengthSq > 0 ? VecDot(ap, ab) / lengthSq : 0;
+			s = std::max(number(0), std::min(number(1), s));
+			ug::vector3 q;
+			VecScaleAdd(q, 1.0, a, s, ab);
+
+			number error = std::max(relative_error(VecDistance(p, q), m_simplifyPositionTolerance),
+									relative_error(std::abs(points.diameter(branch[i]) - (da + s * (db - da))), m_simplifyDiameterTolerance));
+			if (error > maxError) {
+				maxError = error;
+				maxIndex = i;
+			}
+		}
+
+		if (maxError > 1) {
+			keep[branch[maxIndex]] = 1;
+			ranges.push_back(std::make_pair(first, maxIndex));
+			ranges.push_back(std::make_pair(maxIndex, last));
+		}
+	}
+}
+
+size_t Neurolucida::remove_points(Tree& t, const std::vector<char>& keep) const {
+	const size_t numPoints = t.points.size();
+	std::vector<size_t> newIndex(numPoints);
+	size_t numKept = 0;
+	for (size_t i = 0; i < numPoints; i++) {
+		newIndex[i] = numKept;
+		if (keep[i]) numKept++;
+	}
+	if (numKept == numPoints) return 0;
+
+	/// removed points are inner points of branches, thus have exactly one outgoing edge
+	std::vector<size_t> next(numPoints);
+	std::vector<CEdge>::const_iterator it = t.edges.begin();
+	for (; it != t.edges.end(); ++it) {
+		next[it->from] = it->to;
+	}
+
+	std::vector<CEdge> edges;
+	edges.reserve(t.edges.size() - (numPoints - numKept));
+	for (it = t.edges.begin(); it != t.edges.end(); ++it) {
+		if (!keep[it->from]) continue;
+		size_t to = it->to;
+		while (!keep[to]) {
+			to = next[to];
+		}
+		CEdge edge;
+		edge.from = newIndex[it->from];
+		edge.to = newIndex[to];
+		edges.push_back(edge);
+	}
+
+	t.edges.swap(edges);
+	t.points.remove_unkept(keep);
+	return numPoints - numKept;
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_soma_index.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_soma_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	/// upper bound for the number of cells per dimension
+	const int MAX_CELLS_PER_DIM = 128;
+
+	/*!
+	 * \brief closest point on the segment from a to b
+	 */
+	number closest_point_on_segment(const ug::vector3& p, const ug::vector3& a, const ug::vector3& b, ug::vector3& closest) {
+		ug::vector3 ab, ap;
+		ug::VecSubtract(ab, b, a);
+		ug::VecSubtract(ap, p, a);
+		number lengthSq = ug::VecDot(ab, ab);
+		number t = lengthSq > 0 ? ug::VecDot(ap, ab) / lengthSq : 0;
+		t = std::min(std::max(t, number(0)), number(1));
+		ug::VecScaleAdd(closest, 1.0, a, t, ab);
+		return t;
+	}
+
+	struct ClosestVertexVisitor {
+		const ug::vector3& pos;
+		const vector<ug::vector3>& positions;
+		size_t best;
+		number bestDistSq;
+
+		ClosestVertexVisitor(const ug::vector3& p, const vector<ug::vector3>& pp) : pos(p),
+																					positions(pp),
+																					best(numeric_limits<size_t>::max()),
+																					bestDistSq(numeric_limits<number>::max()) {
+		}
+
+		void visit(size_t i) {
+			number distSq = ug::VecDistanceSq(pos, positions[i]);
+			if (distSq < bestDistSq) {
+				bestDistSq = distSq;
+				best = i;
+			}
+		}
+	};
+
+	template <typename TSegment>
+	struct ClosestSegmentVisitor {
+		const ug::vector3& pos;
+		const vector<TSegment>& segments;
+		size_t best;
+		number bestDistSq;
+		number bestT;
+		ug::vector3 bestPoint;
+
+		ClosestSegmentVisitor(const ug::vector3& p, const vector<TSegment>& s) : pos(p),
+																						   segments(s),
+																						   best(numeric_limits<size_t>::max()),
+																						   bestDistSq(numeric_limits<number>::max()),
+																						   bestT(0) {
+		}
+
+		void visit(size_t i) {
+			ug::vector3 closest;
+			number t = closest_point_on_segment(pos, segments[i].fromPos, segments[i].toPos, closest);
+			number distSq = ug::VecDistanceSq(pos, closest);
+			if (distSq < bestDistSq) {
+				bestDistSq = distSq;
+				best = i;
+				bestT = t;
+				bestPoint = closest;
+			}
+		}
+	};
+}
+
+template <typename THandle>
+SomaIndex<THandle>::SomaIndex() : m_cellSize(1) {
+	m_dims[0] = m_dims[1] = m_dims[2] = 0;
+}
+
+template <typename THandle>
+void SomaIndex<THandle>::build(const vector<THandle>& vertices, const vector<ug::vector3>& positions,
+					  const vector<Segment>& segments) {
+	m_vertices = vertices;
+	m_positions = positions;
+	m_segments = segments;
+	m_vertexCells.clear();
+	m_segmentCells.clear();
+	m_dims[0] = m_dims[1] = m_dims[2] = 0;
+	if (m_positions.empty() && m_segments.empty()) return;
+
+	/// bounding box of all vertices and segments
+	ug::vector3 maxCorner;
+	const ug::vector3& first = m_positions.empty() ? m_segments[0].fromPos : m_positions[0];
+	m_min = maxCorner = first;
+	for (size_t i = 0; i < m_positions.size(); i++) {
+		for (size_t d = 0; d < 3; d++) {
+			m_min[d] = min(m_min[d], m_positions[i][d]);
+			maxCorner[d] = max(maxCorner[d], m_positions[i][d]);
+		}
+	}
+	number totalLength = 0;
+	for (size_t i = 0; i < m_segments.size(); i++) {
+		for (size_t d = 0; d < 3; d++) {
+			m_min[d] = min(m_min[d], min(m_segments[i].fromPos[d], m_segments[i].toPos[d]));
+			maxCorner[d] = max(maxCorner[d], max(m_segments[i].fromPos[d], m_segments[i].toPos[d]));
+		}
+		totalLength += ug::VecDistance(m_segments[i].fromPos, m_segments[i].toPos);
+	}
+
+	/// about one item per cell, but cells not smaller than an average edge
+	number extent = 0;
+	for (size_t d = 0; d < 3; d++) {
+		extent = max(extent, maxCorner[d] - m_min[d]);
+	}
+	size_t numItems = max(m_positions.size(), m_segments.size());
+	m_cellSize = extent / cbrt(static_cast<number>(numItems));
+	if (!m_segments.empty()) {
+		m_cellSize = max(m_cellSize, totalLength / m_segments.size());
+	}
+	if (!(m_cellSize > 0)) {
+		m_cellSize = extent > 0 ? extent : 1;
+	}
+
+	for (size_t d = 0; d < 3; d++) {
+		int dim = static_cast<int>(ceil((maxCorner[d] - m_min[d]) / m_cellSize));
+		m_dims[d] = min(max(dim, 1), MAX_CELLS_PER_DIM);
+	}
+	/// enlarge the cells if the number of cells per dimension was limited
+	for (size_t d = 0; d < 3; d++) {
+		m_cellSize = max(m_cellSize, (maxCorner[d] - m_min[d]) / m_dims[d]);
+	}
+
+	size_t numCells = static_cast<size_t>(m_dims[0]) * m_dims[1] * m_dims[2];
+	m_vertexCells.resize(numCells);
+	m_segmentCells.resize(numCells);
+	for (size_t i = 0; i < m_positions.size(); i++) {
+		insert_vertex(i);
+	}
+	for (size_t s = 0; s < m_segments.size(); s++) {
+		insert_segment(s);
+	}
+}
+
+template <typename THandle>
+void SomaIndex<THandle>::cell_of(const ug::vector3& pos, int cell[3]) const {
+	for (size_t d = 0; d < 3; d++) {
+		int c = static_cast<int>(floor((pos[d] - m_min[d]) / m_cellSize));
+		cell[d] = min(max(c, 0), m_dims[d] - 1);
+	}
+}
+
+template <typename THandle>
+size_t SomaIndex<THandle>::cell_index(int i, int j, int k) const {
+	return (static_cast<size_t>(k) * m_dims[1] + j) * m_dims[0] + i;
+}
+
+template <typename THandle>
+void SomaIndex<THandle>::insert_vertex(size_t i) {
+	int cell[3];
+	cell_of(m_positions[i], cell);
+	m_vertexCells[cell_index(cell[0], cell[1], cell[2])].push_back(i);
+}
+
+template <typename THandle>
+void SomaIndex<THandle>::insert_segment(size_t s) {
+	/// all cells overlapped by the bounding box of the segment
+	int lower[3], upper[3];
+	ug::vector3 lowerPos, upperPos;
+	for (size_t d = 0; d < 3; d++) {
+		lowerPos[d] = min(m_segments[s].fromPos[d], m_segments[s].toPos[d]);
+		upperPos[d] = max(m_segments[s].fromPos[d], m_segments[s].toPos[d]);
+	}
+	cell_of(lowerPos, lower);
+	cell_of(upperPos, upper);
+	for (int k = lower[2]; k <= upper[2]; k++) {
+		for (int j = lower[1]; j <= upper[1]; j++) {
+			for (int i = lower[0]; i <= upper[0]; i++) {
+				m_segmentCells[cell_index(i, j, k)].push_back(s);
+			}
+		}
+	}
+}
+
+template <typename THandle>
+template <class TVisitor>
+void SomaIndex<THandle>::visit_shells(const ug::vector3& pos, const vector<vector<size_t> >& cells, TVisitor& visitor) const {
+	int center[3];
+	cell_of(pos, center);
+
+	/// distance of the query to the grid box: for the projection p of pos onto the
+	/// box |pos - x|^2 >= |pos - p|^2 + |p - x|^2 holds for every x in the box
+	number outsideDistSq = 0;
+	for (size_t d = 0; d < 3; d++) {
+		number lower = m_min[d];
+		number upper = m_min[d] + m_dims[d] * m_cellSize;
+		number p = min(max(pos[d], lower), upper);
+		outsideDistSq += (pos[d] - p) * (pos[d] - p);
+	}
+
+	const int maxShell = max(m_dims[0], max(m_dims[1], m_dims[2]));
+	for (int r = 0; r <= maxShell; r++) {
+		for (int k = max(center[2] - r, 0); k <= min(center[2] + r, m_dims[2] - 1); k++) {
+			for (int j = max(center[1] - r, 0); j <= min(center[1] + r, m_dims[1] - 1); j++) {
+				for (int i = max(center[0] - r, 0); i <= min(center[0] + r, m_dims[0] - 1); i++) {
+					/// only the cells on the surface of the shell
+					if (abs(i - center[0]) != r && abs(j - center[1]) != r && abs(k - center[2]) != r) continue;
+					const vector<size_t>& items = cells[cell_index(i, j, k)];
+					for (size_t n = 0; n < items.size(); n++) {
+						visitor.visit(items[n]);
+					}
+				}
+			}
+		}
+
+		/// cells of the next shell are separated from the center cell by r cells
+		number shellDist = r * m_cellSize;
+		if (visitor.bestDistSq <= outsideDistSq + shellDist * shellDist) return;
+	}
+}
+
+template <typename THandle>
+bool SomaIndex<THandle>::closest_vertex(const ug::vector3& pos, THandle& vertex) const {
+	if (m_positions.empty()) return false;
+	ClosestVertexVisitor visitor(pos, m_positions);
+	visit_shells(pos, m_vertexCells, visitor);
+	vertex = m_vertices[visitor.best];
+	return true;
+}
+
+template <typename THandle>
+bool SomaIndex<THandle>::closest_segment(const ug::vector3& pos, size_t& segment, ug::vector3& closest, number& t) const {
+	if (m_segments.empty()) return false;
+	ClosestSegmentVisitor<Segment> visitor(pos, m_segments);
+	visit_shells(pos, m_segmentCells, visitor);
+	segment = visitor.best;
+	closest = visitor.bestPoint;
+	t = visitor.bestT;
+	return true;
+}
+
+template <typename THandle>
+size_t SomaIndex<THandle>::split_segment(size_t segment, THandle vtx, const ug::vector3& pos) {
+	/// both parts lie within the cells of the old segment, thus the old cell entry stays valid
+	Segment second = m_segments[segment];
+	second.from = vtx;
+	second.fromPos = pos;
+	m_segments[segment].to = vtx;
+	m_segments[segment].toPos = pos;
+	m_segments.push_back(second);
+	insert_segment(m_segments.size() - 1);
+
+	m_vertices.push_back(vtx);
+	m_positions.push_back(pos);
+	insert_vertex(m_positions.size() - 1);
+	return m_segments.size() - 1;
+}
+
+template <typename THandle>
+bool SomaIndex<THandle>::segment_end(size_t segment, const ug::vector3& pos, number threshold, THandle& vertex) const {
+	const Segment& s = m_segments[segment];
+	number fromDistSq = VecDistanceSq(s.fromPos, pos);
+	number toDistSq = VecDistanceSq(s.toPos, pos);
+	if (std::min(fromDistSq, toDistSq) >= threshold * threshold) return false;
+	vertex = fromDistSq <= toDistSq ? s.from : s.to;
+	return true;
+}
+
+/// handles used: grid vertices and indices of streamed vertices
+template class ug::neurolucida::SomaIndex<ug::Vertex*>;
+template class ug::neurolucida::SomaIndex<size_t>;
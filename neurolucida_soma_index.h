@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_soma_index.h
+ * \brief uniform grid over the soma vertices and edges for attaching trees
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_SOMA_INDEX__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_SOMA_INDEX__
+
+#include <vector>
+
+#include <common/math/ugmath.h>
+#include "lib_grid/lib_grid.h"
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief nearest neighbor queries on the soma
+		 * The index is built once over all soma vertices and edges and answers
+		 * the query of every tree root by searching the cells in growing shells
+		 * around the query, instead of scanning all soma vertices per tree.
+		 * Vertices are referred to by handles, e.g. grid vertices or indices of
+		 * vertices written to a file.
+		 */
+		template <typename THandle>
+		class SomaIndex {
+		public:
+			/*!
+			 * \brief soma edge given by its vertices
+			 */
+			struct Segment {
+				THandle from;
+				THandle to;
+				ug::vector3 fromPos;
+				ug::vector3 toPos;
+			};
+
+			SomaIndex();
+
+			/*!
+			 * \brief builds the index
+			 * \param[in] vertices soma vertices
+			 * \param[in] positions positions of the soma vertices
+			 * \param[in] segments soma edges
+			 */
+			void build(const std::vector<THandle>& vertices, const std::vector<ug::vector3>& positions,
+					   const std::vector<Segment>& segments);
+
+			/*!
+			 * \brief closest soma vertex
+			 * \return false if there are no soma vertices
+			 */
+			bool closest_vertex(const ug::vector3& pos, THandle& vertex) const;
+
+			/*!
+			 * \brief closest point on any soma edge
+			 * \param[out] segment index of the closest segment
+			 * \param[out] closest closest point on that segment
+			 * \param[out] t local coordinate of the closest point on the segment in [0, 1]
+			 * \return false if there are no soma edges
+			 */
+			bool closest_segment(const ug::vector3& pos, size_t& segment, ug::vector3& closest, number& t) const;
+
+			/*!
+			 * \brief splits a segment at a new vertex
+			 * The segment is replaced by (from, vtx) and (vtx, to). The vertex is
+			 * added to the vertices as well.
+			 * \return index of the new segment (vtx, to)
+			 */
+			size_t split_segment(size_t segment, THandle vtx, const ug::vector3& pos);
+
+			/*!
+			 * \brief end of a segment closer than the threshold to the position
+			 * \return false if both ends are at least the threshold away
+			 */
+			bool segment_end(size_t segment, const ug::vector3& pos, number threshold, THandle& vertex) const;
+
+			inline const Segment& segment(size_t i) const {
+				return m_segments[i];
+			}
+
+			inline size_t num_vertices() const {
+				return m_vertices.size();
+			}
+
+			inline size_t num_segments() const {
+				return m_segments.size();
+			}
+
+		private:
+			void cell_of(const ug::vector3& pos, int cell[3]) const;
+			size_t cell_index(int i, int j, int k) const;
+			void insert_vertex(size_t i);
+			void insert_segment(size_t s);
+
+			/*!
+			 * \brief visits the cells in growing shells around pos
+			 * The functor is called with the items of each cell and the squared lower
+			 * bound of the distance of the cells of the next shell, it returns false to stop.
+			 */
+			template <class TVisitor>
+			void visit_shells(const ug::vector3& pos, const std::vector<std::vector<size_t> >& cells, TVisitor& visitor) const;
+
+		private:
+			ug::vector3 m_min;
+			number m_cellSize;
+			int m_dims[3];
+			std::vector<THandle> m_vertices;
+			std::vector<ug::vector3> m_positions;
+			std::vector<Segment> m_segments;
+			std::vector<std::vector<size_t> > m_vertexCells;
+			std::vector<std::vector<size_t> > m_segmentCells;
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_SOMA_INDEX__
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_statistics.cpp
+ * \brief wall-clock time per phase and counts of a conversion
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_statistics.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "common/log.h"
+#include "common/error.h"
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	const char* PHASE_NAMES[Statistics::NUM_PHASES] = {
+		"read", "parse", "trees", "grid", "soma", "output", "other"
+	};
+
+	const char* COUNTER_NAMES[Statistics::NUM_COUNTERS] = {
+		"points", "tree_edges", "vertices_requested", "vertices", "edges", "subsets", "bytes_read", "bytes_written"
+	};
+}
+
+uint64_t ug::neurolucida::FileSize(const std::string& filename) {
+	ifstream in(filename.c_str(), ios::binary | ios::ate);
+	if (!in) return 0;
+	return static_cast<uint64_t>(in.tellg());
+}
+
+Statistics::Statistics() {
+	clear();
+}
+
+void Statistics::clear() {
+	for (size_t i = 0; i < NUM_PHASES; i++) m_phaseTimes[i] = 0;
+	for (size_t i = 0; i < NUM_COUNTERS; i++) m_counters[i] = 0;
+	m_phases.clear();
+	m_lastChange = Clock::now();
+}
+
+void Statistics::charge(const Clock::time_point& now) {
+	if (!m_phases.empty()) {
+		m_phaseTimes[m_phases.back()] += chrono::duration<double>(now - m_lastChange).count();
+	}
+	m_lastChange = now;
+}
+
+void Statistics::begin_phase(int phase) {
+	charge(Clock::now());
+	m_phases.push_back(phase);
+}
+
+void Statistics::end_phase() {
+	charge(Clock::now());
+	if (!m_phases.empty()) m_phases.pop_back();
+}
+
+double Statistics::total_time() const {
+	double total = 0;
+	for (size_t i = 0; i < NUM_PHASES; i++) total += m_phaseTimes[i];
+	return total;
+}
+
+double Statistics::get_phase_time(const std::string& name) const {
+	if (name == "total") return total_time();
+	for (size_t i = 0; i < NUM_PHASES; i++) {
+		if (name == PHASE_NAMES[i]) return m_phaseTimes[i];
+	}
+	UG_THROW("Unknown phase '" << name << "'.");
+}
+
+size_t Statistics::get_counter(const std::string& name) const {
+	for (size_t i = 0; i < NUM_COUNTERS; i++) {
+		if (name == COUNTER_NAMES[i]) return static_cast<size_t>(m_counters[i]);
+	}
+	UG_THROW("Unknown counter '" << name << "'.");
+}
+
+const char* Statistics::phase_name(int phase) {
+	return PHASE_NAMES[phase];
+}
+
+const char* Statistics::counter_name(int counter) {
+	return COUNTER_NAMES[counter];
+}
+
+void Statistics::print() const {
+	UG_LOG("Neurolucida conversion statistics:" << std::endl);
+	for (size_t i = 0; i < NUM_PHASES; i++) {
+		UG_LOG("\t" << PHASE_NAMES[i] << ": " << m_phaseTimes[i] << " s" << std::endl);
+	}
+	UG_LOG("\ttotal: " << total_time() << " s" << std::endl);
+	for (size_t i = 0; i < NUM_COUNTERS; i++) {
+		UG_LOG("\t" << COUNTER_NAMES[i] << ": " << m_counters[i] << std::endl);
+	}
+}
+
+void Statistics::write_json(std::ostream& out) const {
+	out << std::setprecision(9);
+	out << "{\n\t\"seconds\": {";
+	for (size_t i = 0; i < NUM_PHASES; i++) {
+		out << "\"" << PHASE_NAMES[i] << "\": " << m_phaseTimes[i] << ", ";
+	}
+	out << "\"total\": " << total_time() << "},\n\t\"counters\": {";
+	for (size_t i = 0; i < NUM_COUNTERS; i++) {
+		out << (i ? ", " : "") << "\"" << COUNTER_NAMES[i] << "\": " << m_counters[i];
+	}
+	out << "}\n}\n";
+}
+
+std::string Statistics::get_json() const {
+	std::stringstream ss;
+	write_json(ss);
+	return ss.str();
+}
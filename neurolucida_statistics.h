@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_statistics.h
+ * \brief wall-clock time per phase and counts of a conversion
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_STATISTICS__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_STATISTICS__
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief size of a file in bytes, 0 if it does not exist
+		 */
+		uint64_t FileSize(const std::string& filename);
+
+		/*!
+		 * \brief phase timers and counters of the conversion of one document
+		 * Phases may be nested, the time of a nested phase is not counted for the
+		 * enclosing phase, hence the phase times add up to the total time. Phases
+		 * are only entered by the thread converting the document, work done in
+		 * parallel is part of the phase the thread waits in.
+		 */
+		class Statistics {
+		public:
+			enum Phase {
+				PHASE_READ = 0, ///<! reading, mapping or decompressing the input or the cache
+				PHASE_PARSE = 1, ///<! XML parsing and decoding of contours and trees
+				PHASE_TREES = 2, ///<! simplification, scaling, subset names and colors of the trees
+				PHASE_GRID = 3, ///<! creation of vertices and edges, including the merging of double vertices
+				PHASE_SOMA = 4, ///<! attachment of the trees to the soma
+				PHASE_OUTPUT = 5, ///<! writing and compressing the output files and the cache
+				PHASE_OTHER = 6, ///<! time of the conversion outside of the phases above
+				NUM_PHASES = 7
+			};
+
+			enum Counter {
+				COUNTER_POINTS = 0, ///<! points of the parsed contours and trees
+				COUNTER_TREE_EDGES = 1, ///<! edges of the parsed trees
+				COUNTER_VERTICES_REQUESTED = 2, ///<! vertices requested for points, before merging doubles
+				COUNTER_VERTICES = 3, ///<! vertices created, after merging doubles
+				COUNTER_EDGES = 4, ///<! edges created
+				COUNTER_SUBSETS = 5, ///<! subsets of the output
+				COUNTER_BYTES_READ = 6, ///<! size of the input file respectively the cache file
+				COUNTER_BYTES_WRITTEN = 7, ///<! size of all output files
+				NUM_COUNTERS = 8
+			};
+
+			/*!
+			 * \brief enters a phase for the lifetime of the object
+			 */
+			class ScopedPhase {
+			public:
+				ScopedPhase(Statistics& statistics, int phase) : m_statistics(statistics) {
+					m_statistics.begin_phase(phase);
+				}
+
+				~ScopedPhase() {
+					m_statistics.end_phase();
+				}
+
+			private:
+				ScopedPhase(const ScopedPhase&);
+				ScopedPhase& operator=(const ScopedPhase&);
+
+				Statistics& m_statistics;
+			};
+
+			Statistics();
+
+			/*!
+			 * \brief resets all times and counters
+			 */
+			void clear();
+
+			void begin_phase(int phase);
+			void end_phase();
+
+			inline void add(int counter, uint64_t value) {
+				m_counters[counter] += value;
+			}
+
+			inline void set(int counter, uint64_t value) {
+				m_counters[counter] = value;
+			}
+
+			/*!
+			 * \brief seconds spent in the phase
+			 */
+			inline double phase_time(int phase) const {
+				return m_phaseTimes[phase];
+			}
+
+			inline uint64_t counter(int counter) const {
+				return m_counters[counter];
+			}
+
+			/*!
+			 * \brief seconds of all phases
+			 */
+			double total_time() const;
+
+			/*!
+			 * \brief seconds spent in the phase with the given name, or "total"
+			 */
+			double get_phase_time(const std::string& name) const;
+
+			/*!
+			 * \brief value of the counter with the given name
+			 */
+			size_t get_counter(const std::string& name) const;
+
+			/*!
+			 * \brief name of a phase as used in the output, e.g. "parse"
+			 */
+			static const char* phase_name(int phase);
+
+			/*!
+			 * \brief name of a counter as used in the output, e.g. "vertices_requested"
+			 */
+			static const char* counter_name(int counter);
+
+			/*!
+			 * \brief prints times and counters with UG_LOG
+			 */
+			void print() const;
+
+			/*!
+			 * \brief writes times and counters as JSON object
+			 */
+			void write_json(std::ostream& out) const;
+
+			/*!
+			 * \brief times and counters as JSON object
+			 */
+			std::string get_json() const;
+
+		private:
+			typedef std::chrono::steady_clock Clock;
+
+			/*!
+			 * \brief adds the time since the last phase change to the current phase
+			 */
+			void charge(const Clock::time_point& now);
+
+			double m_phaseTimes[NUM_PHASES];
+			uint64_t m_counters[NUM_COUNTERS];
+			std::vector<int> m_phases; ///<! entered phases, the innermost last
+			Clock::time_point m_lastChange;
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_STATISTICS__
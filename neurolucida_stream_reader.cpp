@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_stream_reader.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_stream_reader.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "common/error.h"
+
+using namespace ug::neurolucida;
+using namespace std;
+
+XMLStreamReader::XMLStreamReader(istream& in, size_t chunkSize) : m_in(in),
+																	m_buffer(chunkSize > 0 ? chunkSize : 1),
+																	m_pos(0),
+																	m_end(0),
+																	m_depth(0),
+																	m_bPendingEnd(false),
+																	m_numAttributes(0) {
+}
+
+bool XMLStreamReader::fill() {
+	if (!m_in) return false;
+	m_in.read(&m_buffer[0], m_buffer.size());
+	m_pos = 0;
+	m_end = static_cast<size_t>(m_in.gcount());
+	return m_end > 0;
+}
+
+void XMLStreamReader::skip_until(const char* terminator) {
+	const size_t len = strlen(terminator);
+	size_t matched = 0;
+	while (matched < len) {
+		int c = get();
+		UG_COND_THROW(c == -1, "Unexpected end of XML file, expected '" << terminator << "'.");
+		if (c == terminator[matched]) {
+			matched++;
+			continue;
+		}
+
+		/// fall back to the longest prefix of the terminator that ends the input read
+		/// so far, so "--->" still closes a comment and "]]]>" a CDATA section
+		size_t k = matched;
+		for (; k > 0; k--) {
+			if (terminator[k - 1] == c && strncmp(terminator, terminator + matched - k + 1, k - 1) == 0) {
+				break;
+			}
+		}
+		matched = k;
+	}
+}
+
+void XMLStreamReader::skip_whitespace() {
+	int c = peek();
+	while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+		m_pos++;
+		c = peek();
+	}
+}
+
+void XMLStreamReader::read_name(string& name) {
+	name.clear();
+	int c = peek();
+	while (c != -1 && c != ' ' && c != '\t' && c != '\n' && c != '\r' && c != '/' && c != '>' && c != '=') {
+		name.push_back(static_cast<char>(c));
+		m_pos++;
+		c = peek();
+	}
+	UG_COND_THROW(name.empty(), "Malformed XML file, expected a name.");
+}
+
+void XMLStreamReader::read_attribute_value(string& value) {
+	value.clear();
+	int quote = get();
+	UG_COND_THROW(quote != '"' && quote != '\'', "Malformed XML file, expected quoted attribute value.");
+	int c = get();
+	while (c != quote) {
+		UG_COND_THROW(c == -1, "Unexpected end of XML file in attribute value.");
+		if (c != '&') {
+			value.push_back(static_cast<char>(c));
+		} else {
+			/// translate predefined and numeric character references
+			string entity;
+			c = get();
+			while (c != ';' && c != -1 && entity.size() < 16) {
+				entity.push_back(static_cast<char>(c));
+				c = get();
+			}
+			UG_COND_THROW(c != ';', "Malformed entity in attribute value.");
+			if (entity == "lt") value.push_back('<');
+			else if (entity == "gt") value.push_back('>');
+			else if (entity == "amp") value.push_back('&');
+			else if (entity == "quot") value.push_back('"');
+			else if (entity == "apos") value.push_back('\'');
+			else if (entity.size() > 1 && entity[0] == '#') {
+				long code = (entity[1] == 'x') ? strtol(entity.c_str() + 2, NULL, 16) : strtol(entity.c_str() + 1, NULL, 10);
+				value.push_back(static_cast<char>(code));
+			} else {
+				value.push_back('&');
+				value.append(entity);
+				value.push_back(';');
+			}
+		}
+		c = get();
+	}
+}
+
+void XMLStreamReader::skip_markup_declaration() {
+	/// "<!" has been consumed already
+	if (peek() == '-') {
+		m_pos++;
+		UG_COND_THROW(get() != '-', "Malformed XML comment.");
+		skip_until("-->");
+	} else if (peek() == '[') {
+		skip_until("]]>");
+	} else {
+		/// DOCTYPE, possibly with an internal subset in brackets
+		int brackets = 0;
+		int c = get();
+		while (c != -1 && !(c == '>' && brackets == 0)) {
+			if (c == '[') brackets++;
+			if (c == ']') brackets--;
+			c = get();
+		}
+		UG_COND_THROW(c == -1, "Unexpected end of XML file in markup declaration.");
+	}
+}
+
+XMLStreamReader::EventType XMLStreamReader::next() {
+	m_numAttributes = 0;
+	if (m_bPendingEnd) {
+		m_bPendingEnd = false;
+		m_depth--;
+		return END_ELEMENT;
+	}
+
+	for (;;) {
+		/// skip text content
+		int c = get();
+		while (c != '<' && c != -1) {
+			c = get();
+		}
+
+		if (c == -1) {
+			UG_COND_THROW(m_depth != 0, "Unexpected end of XML file, " << m_depth << " element(s) not closed.");
+			return END_DOCUMENT;
+		}
+
+		c = get();
+		if (c == '?') {
+			skip_until("?>");
+		} else if (c == '!') {
+			skip_markup_declaration();
+		} else if (c == '/') {
+			read_name(m_name);
+			skip_whitespace();
+			UG_COND_THROW(get() != '>', "Malformed end tag '" << m_name << "'.");
+			UG_COND_THROW(m_depth == 0, "Unbalanced end tag '" << m_name << "'.");
+			m_depth--;
+			return END_ELEMENT;
+		} else {
+			UG_COND_THROW(c == -1, "Unexpected end of XML file in tag.");
+			m_pos--;
+			read_name(m_name);
+			m_depth++;
+			for (;;) {
+				skip_whitespace();
+				c = peek();
+				if (c == '>') {
+					m_pos++;
+					return START_ELEMENT;
+				} else if (c == '/') {
+					m_pos++;
+					UG_COND_THROW(get() != '>', "Malformed empty element tag '" << m_name << "'.");
+					m_bPendingEnd = true;
+					return START_ELEMENT;
+				}
+
+				UG_COND_THROW(c == -1, "Unexpected end of XML file in tag '" << m_name << "'.");
+				if (m_numAttributes == m_attributes.size()) {
+					m_attributes.push_back(pair<string, string>());
+				}
+				pair<string, string>& attribute = m_attributes[m_numAttributes];
+				read_name(attribute.first);
+				skip_whitespace();
+				UG_COND_THROW(get() != '=', "Malformed attribute '" << attribute.first << "' in tag '" << m_name << "'.");
+				skip_whitespace();
+				read_attribute_value(attribute.second);
+				m_numAttributes++;
+			}
+		}
+	}
+}
+
+const char* XMLStreamReader::attribute(const char* name) const {
+	for (size_t i = 0; i < m_numAttributes; i++) {
+		if (m_attributes[i].first == name) {
+			return m_attributes[i].second.c_str();
+		}
+	}
+	return NULL;
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_stream_reader.h
+ * \brief minimal pull parser for Neurolucida XML files
+ *
+ * Reads the input in fixed size chunks and reports start and end tags
+ * one at a time, thus memory consumption does not depend on the file
+ * size. Only the XML subset written by Neurolucida is supported: text
+ * content is skipped, comments, processing instructions, CDATA sections
+ * and the DOCTYPE are ignored and the predefined entities are translated
+ * in attribute values.
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_STREAM_READER__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_STREAM_READER__
+
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ug {
+	namespace neurolucida {
+		class XMLStreamReader {
+		public:
+			enum EventType {
+				START_ELEMENT,
+				END_ELEMENT,
+				END_DOCUMENT
+			};
+
+			/*!
+			 * \brief ctor
+			 * \param[in] in stream to read from
+			 * \param[in] chunkSize number of bytes read from the stream at once
+			 */
+			XMLStreamReader(std::istream& in, size_t chunkSize = 1 << 16);
+
+			/*!
+			 * \brief advances to the next start or end tag
+			 * Empty element tags (<point ... />) are reported as
+			 * START_ELEMENT immediately followed by END_ELEMENT.
+			 */
+			EventType next();
+
+			/*!
+			 * \brief name of the current element
+			 */
+			inline const std::string& name() const {
+				return m_name;
+			}
+
+			/*!
+			 * \brief value of an attribute of the current start tag
+			 * \return NULL if the current element has no such attribute
+			 */
+			const char* attribute(const char* name) const;
+
+			/*!
+			 * \brief number of attributes of the current start tag
+			 */
+			inline size_t num_attributes() const {
+				return m_numAttributes;
+			}
+
+			/*!
+			 * \brief name of the i-th attribute of the current start tag
+			 */
+			inline const std::string& attribute_name(size_t i) const {
+				return m_attributes[i].first;
+			}
+
+			/*!
+			 * \brief value of the i-th attribute of the current start tag
+			 */
+			inline const std::string& attribute_value(size_t i) const {
+				return m_attributes[i].second;
+			}
+
+			/*!
+			 * \brief current nesting depth, i. e. number of open elements
+			 */
+			inline size_t depth() const {
+				return m_depth;
+			}
+
+		private:
+			bool fill();
+			inline int peek() {
+				if (m_pos == m_end && !fill()) return -1;
+				return static_cast<unsigned char>(m_buffer[m_pos]);
+			}
+			inline int get() {
+				int c = peek();
+				if (c != -1) m_pos++;
+				return c;
+			}
+			void skip_until(const char* terminator);
+			void skip_whitespace();
+			void read_name(std::string& name);
+			void read_attribute_value(std::string& value);
+			void skip_markup_declaration();
+
+		private:
+			std::istream& m_in;
+			std::vector<char> m_buffer;
+			size_t m_pos;
+			size_t m_end;
+			size_t m_depth;
+			bool m_bPendingEnd;
+			std::string m_name;
+			std::vector<std::pair<std::string, std::string> > m_attributes; ///<! reused between tags to keep string capacities
+			size_t m_numAttributes;
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_STREAM_READER__
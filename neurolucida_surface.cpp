@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_surface.cpp
+ * \brief triangulated tube surfaces around the edges of the grid
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_surface.h"
+#include "neurolucida_compression.h"
+#include "neurolucida_ugx_writer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	const number SURFACE_PI = 3.14159265358979323846;
+
+	/*!
+	 * \brief chain of edges between two vertices which do not have exactly two edges
+	 */
+	struct Branch {
+		std::vector<size_t> vertices;
+		std::vector<size_t> edges; ///<! edge i connects vertices i and i+1
+		bool capStart; ///<! first vertex is a tip
+		bool capEnd; ///<! last vertex is a tip
+		size_t firstVertex; ///<! of the mesh
+		size_t firstTriangle;
+	};
+
+	/*!
+	 * \brief sphere joining the branches at a vertex
+	 */
+	struct Joint {
+		size_t vertex;
+		size_t firstVertex;
+		size_t firstTriangle;
+	};
+
+	/*!
+	 * \brief edges of each vertex, stored consecutively
+	 */
+	struct Adjacency {
+		std::vector<size_t> offsets;
+		std::vector<std::pair<size_t, size_t> > neighbors; ///<! vertex and edge
+
+		inline size_t degree(size_t v) const {
+			return offsets[v + 1] - offsets[v];
+		}
+	};
+
+	void BuildAdjacency(const OutputGeometry& geometry, Adjacency& adjacency) {
+		const size_t numVertices = geometry.positions.size();
+		adjacency.offsets.assign(numVertices + 1, 0);
+		for (size_t e = 0; e < geometry.edges.size(); e++) {
+			adjacency.offsets[geometry.edges[e].first + 1]++;
+			adjacency.offsets[geometry.edges[e].second + 1]++;
+		}
+		for (size_t v = 0; v < numVertices; v++) {
+			adjacency.offsets[v + 1] += adjacency.offsets[v];
+		}
+		adjacency.neighbors.resize(adjacency.offsets[numVertices]);
+		std::vector<size_t> next(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (size_t e = 0; e < geometry.edges.size(); e++) {
+			size_t a = geometry.edges[e].first;
+			size_t b = geometry.edges[e].second;
+			adjacency.neighbors[next[a]++] = std::make_pair(b, e);
+			adjacency.neighbors[next[b]++] = std::make_pair(a, e);
+		}
+	}
+
+	/*!
+	 * \brief follows the edges from the vertex over vertices with two edges
+	 */
+	void WalkBranch(const Adjacency& adjacency, size_t start, size_t next, size_t edge,
+					std::vector<char>& visited, Branch& branch) {
+		branch.vertices.assign(1, start);
+		branch.edges.clear();
+		while (true) {
+			visited[edge] = true;
+			branch.edges.push_back(edge);
+			branch.vertices.push_back(next);
+			if (adjacency.degree(next) != 2) break;
+
+			/// continue over the other edge of the vertex, unless a loop is closed
+			size_t i = adjacency.offsets[next];
+			if (adjacency.neighbors[i].second == edge) i++;
+			if (visited[adjacency.neighbors[i].second]) break;
+			edge = adjacency.neighbors[i].second;
+			next = adjacency.neighbors[i].first;
+		}
+	}
+
+	/*!
+	 * \brief splits the edges into branches and determines the vertices joining branches
+	 */
+	void CollectBranches(const OutputGeometry& geometry, const Adjacency& adjacency,
+						 std::vector<Branch>& branches, std::vector<Joint>& joints) {
+		const size_t numVertices = geometry.positions.size();
+		std::vector<char> visited(geometry.edges.size(), false);
+		std::vector<char> joint(numVertices, false);
+		for (size_t v = 0; v < numVertices; v++) {
+			if (adjacency.degree(v) == 2 || adjacency.degree(v) == 0) continue;
+			if (adjacency.degree(v) > 2) joint[v] = true;
+			for (size_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; i++) {
+				if (visited[adjacency.neighbors[i].second]) continue;
+				branches.push_back(Branch());
+				WalkBranch(adjacency, v, adjacency.neighbors[i].first, adjacency.neighbors[i].second, visited, branches.back());
+			}
+		}
+
+		/// closed loops of vertices with two edges are joined where they start
+		for (size_t e = 0; e < geometry.edges.size(); e++) {
+			if (visited[e]) continue;
+			size_t v = geometry.edges[e].first;
+			joint[v] = true;
+			branches.push_back(Branch());
+			WalkBranch(adjacency, v, geometry.edges[e].second, e, visited, branches.back());
+		}
+
+		for (size_t i = 0; i < branches.size(); i++) {
+			branches[i].capStart = adjacency.degree(branches[i].vertices.front()) == 1;
+			branches[i].capEnd = adjacency.degree(branches[i].vertices.back()) == 1;
+		}
+		for (size_t v = 0; v < numVertices; v++) {
+			if (!joint[v]) continue;
+			Joint j;
+			j.vertex = v;
+			joints.push_back(j);
+		}
+	}
+
+	inline bool Normalize(ug::vector3& v) {
+		number length = VecLength(v);
+		if (!(length > 0)) return false;
+		VecScale(v, v, 1 / length);
+		return true;
+	}
+
+	/*!
+	 * \brief unit vector perpendicular to the unit vector
+	 */
+	ug::vector3 Perpendicular(const ug::vector3& t) {
+		size_t axis = 0;
+		for (size_t d = 1; d < 3; d++) {
+			if (std::abs(t[d]) < std::abs(t[axis])) axis = d;
+		}
+		ug::vector3 n(0, 0, 0);
+		n[axis] = 1;
+		VecScaleAdd(n, 1, n, -t[axis], t);
+		Normalize(n);
+		return n;
+	}
+
+	/*!
+	 * \brief adds the triangles connecting two rings, with the given first vertices
+	 */
+	inline void ConnectRings(size_t ring, size_t nextRing, size_t n, int si, size_t*& triangle, int*& subset) {
+		for (size_t k = 0; k < n; k++) {
+			size_t k1 = (k + 1) % n;
+			triangle[0] = ring + k; triangle[1] = ring + k1; triangle[2] = nextRing + k1;
+			triangle[3] = ring + k; triangle[4] = nextRing + k1; triangle[5] = nextRing + k;
+			triangle += 6;
+			*subset++ = si;
+			*subset++ = si;
+		}
+	}
+
+	/*!
+	 * \brief creates the rings, the triangles and the caps of a branch
+	 */
+	void CreateBranch(const OutputGeometry& geometry, const Branch& branch, const std::vector<number>& cosines,
+					  const std::vector<number>& sines, SurfaceMesh& mesh) {
+		const size_t n = cosines.size();
+		const size_t m = branch.vertices.size();
+
+		/// tangents, interior ones bisect the adjacent segments
+		std::vector<ug::vector3> tangents(m);
+		std::vector<ug::vector3> segments(m - 1);
+		for (size_t i = 0; i + 1 < m; i++) {
+			VecSubtract(segments[i], geometry.positions[branch.vertices[i+1]], geometry.positions[branch.vertices[i]]);
+			Normalize(segments[i]);
+		}
+		tangents[0] = segments[0];
+		tangents[m-1] = segments[m-2];
+		for (size_t i = 1; i + 1 < m; i++) {
+			VecAdd(tangents[i], segments[i-1], segments[i]);
+			if (!Normalize(tangents[i])) tangents[i] = segments[i];
+		}
+
+		/// parallel transport of the normal by double reflection, see Wang et al.,
+		/// Computation of rotation minimizing frames, ACM TOG 27 (2008)
+		ug::vector3 normal = Perpendicular(tangents[0]);
+		ug::vector3* position = &mesh.positions[branch.firstVertex];
+		for (size_t i = 0; i < m; i++) {
+			if (i > 0) {
+				ug::vector3 v1, rL, tL, v2;
+				VecSubtract(v1, geometry.positions[branch.vertices[i]], geometry.positions[branch.vertices[i-1]]);
+				number c1 = VecDot(v1, v1);
+				if (c1 > 0) {
+					VecScaleAdd(rL, 1, normal, -2 / c1 * VecDot(v1, normal), v1);
+					VecScaleAdd(tL, 1, tangents[i-1], -2 / c1 * VecDot(v1, tangents[i-1]), v1);
+					VecSubtract(v2, tangents[i], tL);
+					number c2 = VecDot(v2, v2);
+					if (c2 > 0) {
+						VecScaleAdd(normal, 1, rL, -2 / c2 * VecDot(v2, rL), v2);
+					} else {
+						normal = rL;
+					}
+				}
+			}
+			ug::vector3 binormal;
+			VecCross(binormal, tangents[i], normal);
+
+			/// ring of the point, the angles are tabulated once
+			const ug::vector3& center = geometry.positions[branch.vertices[i]];
+			const number radius = number(0.5) * geometry.diameters[branch.vertices[i]];
+			const number nx = radius * normal[0], ny = radius * normal[1], nz = radius * normal[2];
+			const number bx = radius * binormal[0], by = radius * binormal[1], bz = radius * binormal[2];
+			for (size_t k = 0; k < n; k++) {
+				position[k][0] = center[0] + cosines[k] * nx + sines[k] * bx;
+				position[k][1] = center[1] + cosines[k] * ny + sines[k] * by;
+				position[k][2] = center[2] + cosines[k] * nz + sines[k] * bz;
+			}
+			position += n;
+		}
+
+		size_t* triangle = &mesh.triangles[3 * branch.firstTriangle];
+		int* subset = &mesh.triangleSubsets[branch.firstTriangle];
+		for (size_t i = 0; i + 1 < m; i++) {
+			ConnectRings(branch.firstVertex + i * n, branch.firstVertex + (i + 1) * n, n, geometry.edgeSubsets[branch.edges[i]], triangle, subset);
+		}
+
+		/// flat caps, oriented against respectively along the tangent
+		size_t center = branch.firstVertex + m * n;
+		if (branch.capStart) {
+			*position++ = geometry.positions[branch.vertices.front()];
+			size_t ring = branch.firstVertex;
+			for (size_t k = 0; k < n; k++) {
+				triangle[0] = center; triangle[1] = ring + (k + 1) % n; triangle[2] = ring + k;
+				triangle += 3;
+				*subset++ = geometry.edgeSubsets[branch.edges.front()];
+			}
+			center++;
+		}
+		if (branch.capEnd) {
+			*position++ = geometry.positions[branch.vertices.back()];
+			size_t ring = branch.firstVertex + (m - 1) * n;
+			for (size_t k = 0; k < n; k++) {
+				triangle[0] = center; triangle[1] = ring + k; triangle[2] = ring + (k + 1) % n;
+				triangle += 3;
+				*subset++ = geometry.edgeSubsets[branch.edges.back()];
+			}
+		}
+	}
+
+	inline size_t NumLatitudes(size_t n) {
+		return std::max(size_t(2), n / 2);
+	}
+
+	/*!
+	 * \brief creates the sphere at a vertex joining branches
+	 */
+	void CreateJoint(const OutputGeometry& geometry, const Adjacency& adjacency, const Joint& joint,
+					 const std::vector<number>& cosines, const std::vector<number>& sines, SurfaceMesh& mesh) {
+		const size_t n = cosines.size();
+		const size_t numLatitudes = NumLatitudes(n);
+		const ug::vector3& center = geometry.positions[joint.vertex];
+		const number radius = number(0.5) * geometry.diameters[joint.vertex];
+		int si = geometry.vertexSubsets[joint.vertex];
+		if (si < 0) si = geometry.edgeSubsets[adjacency.neighbors[adjacency.offsets[joint.vertex]].second];
+
+		/// poles and rings of latitude from north to south
+		ug::vector3* position = &mesh.positions[joint.firstVertex];
+		*position++ = ug::vector3(center[0], center[1], center[2] + radius);
+		for (size_t j = 1; j < numLatitudes; j++) {
+			const number phi = SURFACE_PI * j / numLatitudes;
+			const number r = radius * std::sin(phi);
+			const number z = center[2] + radius * std::cos(phi);
+			for (size_t k = 0; k < n; k++) {
+				position[k][0] = center[0] + r * cosines[k];
+				position[k][1] = center[1] + r * sines[k];
+				position[k][2] = z;
+			}
+			position += n;
+		}
+		*position = ug::vector3(center[0], center[1], center[2] - radius);
+
+		const size_t north = joint.firstVertex;
+		const size_t south = joint.firstVertex + 1 + (numLatitudes - 1) * n;
+		size_t* triangle = &mesh.triangles[3 * joint.firstTriangle];
+		int* subset = &mesh.triangleSubsets[joint.firstTriangle];
+		for (size_t k = 0; k < n; k++) {
+			triangle[0] = north; triangle[1] = north + 1 + k; triangle[2] = north + 1 + (k + 1) % n;
+			triangle += 3;
+			*subset++ = si;
+		}
+		for (size_t j = 1; j + 1 < numLatitudes; j++) {
+			size_t ring = north + 1 + (j - 1) * n;
+			size_t nextRing = ring + n;
+			for (size_t k = 0; k < n; k++) {
+				size_t k1 = (k + 1) % n;
+				triangle[0] = ring + k; triangle[1] = nextRing + k; triangle[2] = nextRing + k1;
+				triangle[3] = ring + k; triangle[4] = nextRing + k1; triangle[5] = ring + k1;
+				triangle += 6;
+				*subset++ = si;
+				*subset++ = si;
+			}
+		}
+		size_t ring = north + 1 + (numLatitudes - 2) * n;
+		for (size_t k = 0; k < n; k++) {
+			triangle[0] = south; triangle[1] = ring + (k + 1) % n; triangle[2] = ring + k;
+			triangle += 3;
+			*subset++ = si;
+		}
+	}
+}
+
+void ug::neurolucida::CreateTubeSurface(ThreadPool& pool, const OutputGeometry& geometry, size_t numRingVertices, SurfaceMesh& mesh) {
+	const size_t n = std::max(size_t(3), numRingVertices);
+	mesh.subsetNames = geometry.subsetNames;
+	mesh.subsetColors = geometry.subsetColors;
+
+	Adjacency adjacency;
+	BuildAdjacency(geometry, adjacency);
+	std::vector<Branch> branches;
+	std::vector<Joint> joints;
+	CollectBranches(geometry, adjacency, branches, joints);
+
+	/// every branch and joint fills its own range of the mesh, thus they are created independently
+	size_t numVertices = 0;
+	size_t numTriangles = 0;
+	for (size_t i = 0; i < branches.size(); i++) {
+		Branch& branch = branches[i];
+		size_t numCaps = (branch.capStart ? 1 : 0) + (branch.capEnd ? 1 : 0);
+		branch.firstVertex = numVertices;
+		branch.firstTriangle = numTriangles;
+		numVertices += branch.vertices.size() * n + numCaps;
+		numTriangles += (branch.vertices.size() - 1) * 2 * n + numCaps * n;
+	}
+	const size_t numLatitudes = NumLatitudes(n);
+	for (size_t i = 0; i < joints.size(); i++) {
+		joints[i].firstVertex = numVertices;
+		joints[i].firstTriangle = numTriangles;
+		numVertices += 2 + (numLatitudes - 1) * n;
+		numTriangles += 2 * n * (numLatitudes - 1);
+	}
+	mesh.positions.resize(numVertices);
+	mesh.triangles.resize(3 * numTriangles);
+	mesh.triangleSubsets.resize(numTriangles);
+
+	std::vector<number> cosines(n);
+	std::vector<number> sines(n);
+	for (size_t k = 0; k < n; k++) {
+		cosines[k] = std::cos(2 * SURFACE_PI * k / n);
+		sines[k] = std::sin(2 * SURFACE_PI * k / n);
+	}
+
+	ParallelFor(pool, branches.size() + joints.size(), [&](size_t i) {
+		if (i < branches.size()) {
+			CreateBranch(geometry, branches[i], cosines, sines, mesh);
+		} else {
+			CreateJoint(geometry, adjacency, joints[i - branches.size()], cosines, sines, mesh);
+		}
+	});
+}
+
+bool ug::neurolucida::WriteSurfaceOBJ(const SurfaceMesh& mesh, const std::string& filename, int compression) {
+	OutputFile out;
+	if (!out.open(filename, compression)) return false;
+	out.precision(numeric_limits<double>::digits10 + 2);
+
+	for (size_t i = 0; i < mesh.positions.size(); i++) {
+		const ug::vector3& pos = mesh.positions[i];
+		out << "v " << pos[0] << ' ' << pos[1] << ' ' << pos[2] << '\n';
+	}
+
+	/// triangles grouped by subset, triangles without subset are written last
+	const size_t numSubsets = mesh.subsetNames.size();
+	std::vector<std::vector<size_t> > trianglesOfSubset(numSubsets + 1);
+	for (size_t i = 0; i < mesh.triangleSubsets.size(); i++) {
+		int si = mesh.triangleSubsets[i];
+		trianglesOfSubset[si >= 0 ? static_cast<size_t>(si) : numSubsets].push_back(i);
+	}
+
+	for (size_t si = 0; si <= numSubsets; si++) {
+		const std::vector<size_t>& triangles = trianglesOfSubset[si];
+		if (triangles.empty()) continue;
+		out << "o " << (si < numSubsets ? mesh.subsetNames[si] : "unassigned") << '\n';
+		for (size_t i = 0; i < triangles.size(); i++) {
+			/// OBJ indices start at 1
+			const size_t* t = &mesh.triangles[3 * triangles[i]];
+			out << "f " << t[0] + 1 << ' ' << t[1] + 1 << ' ' << t[2] + 1 << '\n';
+		}
+	}
+
+	return out.close();
+}
+
+bool ug::neurolucida::WriteSurfaceUGX(const SurfaceMesh& mesh, const std::string& filename, int compression) {
+	OutputFile out;
+	if (!out.open(filename, compression)) return false;
+	out.precision(numeric_limits<double>::digits10 + 2);
+
+	out << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+	out << "<grid name=\"defGrid\">\n";
+	out << "<vertices coords=\"3\">";
+	for (size_t i = 0; i < mesh.positions.size(); i++) {
+		const ug::vector3& pos = mesh.positions[i];
+		out << pos[0] << ' ' << pos[1] << ' ' << pos[2] << ' ';
+	}
+	out << "</vertices>\n";
+	out << "<triangles>";
+	for (size_t i = 0; i < mesh.triangles.size(); i++) {
+		out << mesh.triangles[i] << ' ';
+	}
+	out << "</triangles>\n";
+
+	/// subsets without triangles are omitted
+	const size_t numSubsets = mesh.subsetNames.size();
+	std::vector<std::vector<size_t> > trianglesOfSubset(numSubsets);
+	for (size_t i = 0; i < mesh.triangleSubsets.size(); i++) {
+		int si = mesh.triangleSubsets[i];
+		if (si >= 0 && static_cast<size_t>(si) < numSubsets) trianglesOfSubset[si].push_back(i);
+	}
+	out << "<subset_handler name=\"defSH\">\n";
+	for (size_t si = 0; si < numSubsets; si++) {
+		const std::vector<size_t>& triangles = trianglesOfSubset[si];
+		if (triangles.empty()) continue;
+		const ug::MathVector<4>& color = mesh.subsetColors[si];
+		out << "<subset name=\"" << XMLEscape(mesh.subsetNames[si]) << "\" color=\"" << color[0] << ' ' << color[1] << ' '
+			<< color[2] << ' ' << color[3] << "\" state=\"0\">\n";
+		out << "<faces>";
+		for (size_t i = 0; i < triangles.size(); i++) {
+			out << triangles[i] << ' ';
+		}
+		out << "</faces>\n";
+		out << "</subset>\n";
+	}
+	out << "</subset_handler>\n";
+	out << "</grid>\n";
+
+	return out.close();
+}
+
+bool SurfaceSink::write(const OutputGeometry& geometry, const std::string& filename, int compression) const {
+	ThreadPool pool(m_numThreads);
+	SurfaceMesh mesh;
+	CreateTubeSurface(pool, geometry, m_numRingVertices, mesh);
+	if (m_format == FORMAT_UGX) return WriteSurfaceUGX(mesh, filename, compression);
+	return WriteSurfaceOBJ(mesh, filename, compression);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_surface.h
+ * \brief triangulated tube surfaces around the edges of the grid
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_SURFACE__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_SURFACE__
+
+#include <string>
+#include <vector>
+
+#include <common/math/ugmath.h>
+
+#include "neurolucida_output_sink.h"
+#include "neurolucida_thread_pool.h"
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief triangle mesh, triangles are oriented with outward normals
+		 */
+		struct SurfaceMesh {
+			std::vector<ug::vector3> positions;
+			std::vector<size_t> triangles; ///<! three vertex indices per triangle
+			std::vector<int> triangleSubsets; ///<! -1 for none
+			std::vector<std::string> subsetNames;
+			std::vector<ug::MathVector<4> > subsetColors;
+		};
+
+		/*!
+		 * \brief creates the tube surface around the edges of the geometry
+		 * The edges are split into branches, i.e. chains of edges between vertices
+		 * which do not have exactly two edges. Every point of a branch gets a ring
+		 * of vertices with the radius of the point, oriented by a parallel transport
+		 * (rotation minimizing) frame along the branch, and consecutive rings are
+		 * connected by triangles. Tips are closed by flat caps. Branches meeting at
+		 * a vertex are joined by a sphere with the radius of the vertex, which
+		 * overlaps the open ends of the tubes; overlaps are not removed.
+		 * Rings and spheres are created in parallel on the pool, the mesh does not
+		 * depend on the number of threads.
+		 * \param[in] numRingVertices vertices per ring, at least 3
+		 */
+		void CreateTubeSurface(ThreadPool& pool, const OutputGeometry& geometry, size_t numRingVertices, SurfaceMesh& mesh);
+
+		/*!
+		 * \brief writes the mesh as Wavefront OBJ with one object per subset
+		 */
+		bool WriteSurfaceOBJ(const SurfaceMesh& mesh, const std::string& filename, int compression);
+
+		/*!
+		 * \brief writes the mesh as UGX with triangles and the subsets of the triangles
+		 */
+		bool WriteSurfaceUGX(const SurfaceMesh& mesh, const std::string& filename, int compression);
+
+		/*!
+		 * \brief writes the tube surface of the grid, see CreateTubeSurface
+		 */
+		class SurfaceSink : public OutputSink {
+		public:
+			enum Format {
+				FORMAT_OBJ = 1,
+				FORMAT_UGX = 2
+			};
+
+			/*!
+			 * \param[in] format one of Format
+			 * \param[in] numRingVertices vertices per ring, at least 3
+			 * \param[in] numThreads threads creating the surface, 0 uses all hardware threads
+			 */
+			SurfaceSink(int format, size_t numRingVertices, size_t numThreads) : m_format(format),
+																			   m_numRingVertices(numRingVertices),
+																			   m_numThreads(numThreads) {}
+
+			virtual std::string extension() const {
+				return m_format == FORMAT_UGX ? ".surface.ugx" : ".surface.obj";
+			}
+
+			virtual bool write(const OutputGeometry& geometry, const std::string& filename, int compression) const;
+
+		private:
+			int m_format;
+			size_t m_numRingVertices;
+			size_t m_numThreads;
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_SURFACE__
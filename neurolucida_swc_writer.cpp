@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_swc_writer.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_swc_writer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+using namespace ug::neurolucida;
+using namespace std;
+
+int ug::neurolucida::SwcTypeOfTree(const std::string& treeType) {
+	string type = treeType;
+	transform(type.begin(), type.end(), type.begin(), ::tolower);
+	if (type.find("axon") != string::npos) return SWC_AXON;
+	if (type.find("apical") != string::npos) return SWC_APICAL_DENDRITE;
+	if (type.find("dendrite") != string::npos || type.find("basal") != string::npos) return SWC_BASAL_DENDRITE;
+	return SWC_UNDEFINED;
+}
+
+const long SwcWriter::NO_PARENT;
+
+SwcWriter::SwcWriter() : m_numSamples(0) {
+}
+
+bool SwcWriter::open(const std::string& filename, const std::string& source, int compression) {
+	close();
+	m_numSamples = 0;
+	m_somaIds.clear();
+	m_somaPositions.clear();
+
+	if (!m_out.open(filename, compression)) return false;
+
+	m_out << "# converted from '" << source << "' by the ug4 Neurolucida plugin\n";
+	m_out << "# id type x y z radius parent\n";
+	m_out.precision(10);
+	return true;
+}
+
+bool SwcWriter::close() {
+	if (!m_out.is_open()) return true;
+	return m_out.close();
+}
+
+long SwcWriter::write_sample(int type, const MathVector<4>& point, long parent) {
+	long id = ++m_numSamples;
+	m_out << id << ' ' << type << ' ' << point[0] << ' ' << point[1] << ' ' << point[2] << ' '
+		  << point[3] / 2 << ' ' << parent << '\n';
+	return id;
+}
+
+long SwcWriter::write_soma_sample(const MathVector<4>& point, long parent) {
+	long id = write_sample(SWC_SOMA, point, parent);
+	m_somaIds.push_back(id);
+	m_somaPositions.push_back(ug::vector3(point[0], point[1], point[2]));
+	return id;
+}
+
+long SwcWriter::closest_soma_sample(const MathVector<4>& point) const {
+	ug::vector3 pos(point[0], point[1], point[2]);
+	long closest = NO_PARENT;
+	number bestDistSq = numeric_limits<number>::max();
+	for (size_t i = 0; i < m_somaPositions.size(); i++) {
+		number distSq = ug::VecDistanceSq(pos, m_somaPositions[i]);
+		if (distSq < bestDistSq) {
+			bestDistSq = distSq;
+			closest = m_somaIds[i];
+		}
+	}
+	return closest;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_swc_writer.h
+ * \brief writes samples in the SWC format
+ *
+ * Samples are written as soon as they are added, thus no grid and no copy of
+ * the morphology is required. Each sample refers to its parent by the id
+ * returned when the parent was written, hence parents always precede their
+ * children as required by SWC.
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_SWC_WRITER__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_SWC_WRITER__
+
+#include <string>
+#include <vector>
+
+#include <common/math/ugmath.h>
+
+#include "neurolucida_compression.h"
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief SWC structure identifiers
+		 */
+		enum SwcType {
+			SWC_UNDEFINED = 0,
+			SWC_SOMA = 1,
+			SWC_AXON = 2,
+			SWC_BASAL_DENDRITE = 3,
+			SWC_APICAL_DENDRITE = 4
+		};
+
+		/*!
+		 * \brief SWC structure identifier of a Neurolucida tree type
+		 * \param[in] treeType e.g. 'Axon', 'Dendrite' or 'Apical'
+		 */
+		int SwcTypeOfTree(const std::string& treeType);
+
+		class SwcWriter {
+		public:
+			/// id of the parent of samples without parent
+			static const long NO_PARENT = -1;
+
+			SwcWriter();
+
+			/*!
+			 * \brief opens the output file and writes the header
+			 * \param[in] filename output file
+			 * \param[in] source name of the converted file, written to the header
+			 * \param[in] compression one of Compression, the file is compressed while written
+			 * \return false if the file could not be opened
+			 */
+			bool open(const std::string& filename, const std::string& source, int compression = COMPRESSION_NONE);
+
+			/*!
+			 * \brief closes the output file
+			 * \return false if not all samples could be written
+			 */
+			bool close();
+
+			inline bool is_open() const {
+				return m_out.is_open();
+			}
+
+			/*!
+			 * \brief writes a sample
+			 * \param[in] type SWC structure identifier
+			 * \param[in] point position and diameter (SWC stores the radius)
+			 * \param[in] parent id of the parent sample or NO_PARENT
+			 * \return id of the sample
+			 */
+			long write_sample(int type, const MathVector<4>& point, long parent);
+
+			/*!
+			 * \brief writes a soma sample and remembers it for closest_soma_sample
+			 */
+			long write_soma_sample(const MathVector<4>& point, long parent);
+
+			/*!
+			 * \brief closest soma sample written so far, NO_PARENT if there is none
+			 */
+			long closest_soma_sample(const MathVector<4>& point) const;
+
+		private:
+			OutputFile m_out;
+			long m_numSamples;
+			std::vector<long> m_somaIds;
+			std::vector<ug::vector3> m_somaPositions;
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_SWC_WRITER__
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_thread_pool.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_thread_pool.h"
+
+#include <exception>
+
+#include "common/log.h"
+#include "common/error.h"
+
+using namespace ug::neurolucida;
+using namespace std;
+
+namespace {
+	/// pool and index of the worker running on the current thread, if any
+	thread_local const ThreadPool* currentPool = NULL;
+	thread_local size_t currentWorker = 0;
+}
+
+size_t ThreadPool::default_num_threads() {
+	size_t numThreads = thread::hardware_concurrency();
+	return numThreads > 0 ? numThreads : 1;
+}
+
+ThreadPool::ThreadPool(size_t numThreads) : m_queued(0),
+											m_pending(0),
+											m_next(0),
+											m_bStop(false) {
+	if (numThreads == 0) numThreads = default_num_threads();
+	for (size_t i = 0; i < numThreads; i++) {
+		m_queues.push_back(unique_ptr<Queue>(new Queue()));
+	}
+	for (size_t i = 0; i < numThreads; i++) {
+		m_threads.push_back(thread(&ThreadPool::run, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	wait();
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_bStop = true;
+	}
+	m_cvWork.notify_all();
+	for (size_t i = 0; i < m_threads.size(); i++) {
+		m_threads[i].join();
+	}
+}
+
+void ThreadPool::submit(const Task& task) {
+	/// the task is counted before it becomes visible, otherwise a worker could
+	/// pop and finish it first and wait() could return before it is done
+	size_t id;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_queued++;
+		m_pending++;
+		if (currentPool == this) {
+			id = currentWorker;
+		} else {
+			id = m_next;
+			m_next = (m_next + 1) % m_queues.size();
+		}
+	}
+
+	{
+		lock_guard<mutex> lock(m_queues[id]->mutex);
+		m_queues[id]->tasks.push_back(task);
+	}
+	m_cvWork.notify_one();
+}
+
+void ThreadPool::wait() {
+	unique_lock<mutex> lock(m_mutex);
+	while (m_pending != 0) {
+		m_cvDone.wait(lock);
+	}
+}
+
+bool ThreadPool::pop(size_t id, Task& task) {
+	/// own queue first (LIFO), then steal from the others (FIFO)
+	for (size_t i = 0; i < m_queues.size(); i++) {
+		Queue& queue = *m_queues[(id + i) % m_queues.size()];
+		lock_guard<mutex> lock(queue.mutex);
+		if (queue.tasks.empty()) continue;
+		if (i == 0) {
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+		} else {
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::run(size_t id) {
+	currentPool = this;
+	currentWorker = id;
+
+	for (;;) {
+		Task task;
+		if (pop(id, task)) {
+			{
+				lock_guard<mutex> lock(m_mutex);
+				m_queued--;
+			}
+
+			try {
+				task();
+			} catch (const UGError& err) {
+				UG_LOGN("ThreadPool: task failed: " << err.get_msg());
+			} catch (const std::exception& e) {
+				UG_LOGN("ThreadPool: task failed: " << e.what());
+			} catch (...) {
+				UG_LOGN("ThreadPool: task failed with unknown exception.");
+			}
+
+			lock_guard<mutex> lock(m_mutex);
+			if (--m_pending == 0) m_cvDone.notify_all();
+			continue;
+		}
+
+		unique_lock<mutex> lock(m_mutex);
+		while (!m_bStop && m_queued == 0) {
+			m_cvWork.wait(lock);
+		}
+		if (m_bStop && m_queued == 0) return;
+	}
+}
+
+void ug::neurolucida::ParallelFor(ThreadPool& pool, size_t n, const std::function<void (size_t)>& body) {
+	vector<exception_ptr> errors(n);
+	for (size_t i = 0; i < n; i++) {
+		pool.submit([&body, &errors, i]() {
+			try {
+				body(i);
+			} catch (...) {
+				errors[i] = current_exception();
+			}
+		});
+	}
+	pool.wait();
+
+	for (size_t i = 0; i < n; i++) {
+		if (errors[i]) rethrow_exception(errors[i]);
+	}
+}
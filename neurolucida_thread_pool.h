@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_thread_pool.h
+ * \brief work-stealing thread pool used for parallel conversions
+ *
+ * Every worker owns a task queue. Workers take tasks from the back of their
+ * own queue and steal from the front of other queues if theirs is empty, so
+ * long running tasks (e.g. large morphologies) do not leave workers idle.
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_THREAD_POOL__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_THREAD_POOL__
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ug {
+	namespace neurolucida {
+		class ThreadPool {
+		public:
+			typedef std::function<void ()> Task;
+
+			/*!
+			 * \brief starts the workers
+			 * \param[in] numThreads number of workers, 0 uses the number of hardware threads
+			 */
+			explicit ThreadPool(size_t numThreads = 0);
+
+			/*!
+			 * \brief waits for all submitted tasks and joins the workers
+			 */
+			~ThreadPool();
+
+			/*!
+			 * \brief submits a task
+			 * Tasks submitted by a worker are queued at this worker, other tasks
+			 * are distributed round robin. Exceptions thrown by a task are caught
+			 * and logged, thus tasks should handle errors themselves.
+			 */
+			void submit(const Task& task);
+
+			/*!
+			 * \brief blocks until all submitted tasks have finished
+			 */
+			void wait();
+
+			inline size_t num_threads() const {
+				return m_threads.size();
+			}
+
+			/*!
+			 * \brief number of threads used if 0 threads are requested
+			 */
+			static size_t default_num_threads();
+
+		private:
+			struct Queue {
+				std::mutex mutex;
+				std::deque<Task> tasks;
+			};
+
+			void run(size_t id);
+			bool pop(size_t id, Task& task);
+
+			/// not copyable
+			ThreadPool(const ThreadPool&);
+			ThreadPool& operator=(const ThreadPool&);
+
+		private:
+			std::vector<std::unique_ptr<Queue> > m_queues;
+			std::vector<std::thread> m_threads;
+			std::mutex m_mutex;
+			std::condition_variable m_cvWork;
+			std::condition_variable m_cvDone;
+			size_t m_queued; ///<! tasks in queues
+			size_t m_pending; ///<! tasks queued or running
+			size_t m_next; ///<! queue for the next task submitted from outside
+			bool m_bStop;
+		};
+
+		/*!
+		 * \brief calls body(i) for all i in [0, n) on the workers of the pool
+		 * Blocks until all calls have finished. If calls throw, the exception of
+		 * the call with the smallest index is rethrown, independent of the order
+		 * the calls were run in. Must not be called from a worker of the pool.
+		 */
+		void ParallelFor(ThreadPool& pool, size_t n, const std::function<void (size_t)>& body);
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_THREAD_POOL__
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_ugx_writer.cpp
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include "neurolucida_ugx_writer.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace ug::neurolucida;
+using namespace std;
+
+std::string ug::neurolucida::XMLEscape(const std::string& str) {
+	string escaped;
+	escaped.reserve(str.size());
+	for (size_t i = 0; i < str.size(); i++) {
+		switch (str[i]) {
+			case '&': escaped += "&amp;"; break;
+			case '<': escaped += "&lt;"; break;
+			case '>': escaped += "&gt;"; break;
+			case '"': escaped += "&quot;"; break;
+			default: escaped += str[i];
+		}
+	}
+	return escaped;
+}
+
+const size_t UGXStreamWriter::BLOCK_SIZE;
+
+UGXStreamWriter::UGXStreamWriter(number threshold) : m_blockVertices(0),
+													 m_blockEdges(0),
+													 m_numEdges(0),
+													 m_vertexHash(threshold) {
+}
+
+bool UGXStreamWriter::open(const std::string& filename, int compression) {
+	close();
+	m_vertexBlock.str("");
+	m_edgeBlock.str("");
+	m_blockVertices = m_blockEdges = m_numEdges = 0;
+	m_vertexHash.clear();
+	m_edges.clear();
+	m_diameters.clear();
+	m_subsets.clear();
+
+	if (!m_out.open(filename, compression)) return false;
+
+	/// enough digits to read back the same doubles
+	m_out.precision(numeric_limits<double>::digits10 + 2);
+	m_vertexBlock.precision(numeric_limits<double>::digits10 + 2);
+	m_out << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+	m_out << "<grid name=\"defGrid\">\n";
+	return true;
+}
+
+size_t UGXStreamWriter::vertex(const ug::vector3& pos, number diameter, int si, bool& created) {
+	size_t index;
+	created = !m_vertexHash.find(pos, index);
+	if (!created) return index;
+
+	index = add_vertex(pos, diameter, si);
+	m_vertexHash.insert(index, pos);
+	return index;
+}
+
+size_t UGXStreamWriter::add_vertex(const ug::vector3& pos, number diameter, int si) {
+	size_t index = m_diameters.size();
+	m_diameters.push_back(diameter);
+	if (si >= 0) add_to_ranges(subset(si).vertices, index);
+
+	m_vertexBlock << pos[0] << ' ' << pos[1] << ' ' << pos[2] << ' ';
+	if (++m_blockVertices >= BLOCK_SIZE) flush();
+	return index;
+}
+
+void UGXStreamWriter::edge(size_t from, size_t to, int si) {
+	if (from == to) return;
+	if (!m_edges.insert(make_pair(min(from, to), max(from, to))).second) return;
+	add_edge(from, to, si);
+}
+
+void UGXStreamWriter::add_edge(size_t from, size_t to, int si) {
+	if (si >= 0) add_to_ranges(subset(si).edges, m_numEdges);
+	m_numEdges++;
+
+	m_edgeBlock << from << ' ' << to << ' ';
+	if (++m_blockEdges >= BLOCK_SIZE) flush();
+}
+
+void UGXStreamWriter::set_subset_info(int si, const std::string& name, const ug::MathVector<4>& color) {
+	Subset& s = subset(si);
+	s.name = name;
+	s.color = color;
+}
+
+UGXStreamWriter::Subset& UGXStreamWriter::subset(int si) {
+	if (static_cast<size_t>(si) >= m_subsets.size()) {
+		m_subsets.resize(si + 1);
+	}
+	return m_subsets[si];
+}
+
+void UGXStreamWriter::flush() {
+	/// edges refer to vertices of this or previous blocks, thus vertices are written first
+	if (m_blockVertices > 0) {
+		m_out << "<vertices coords=\"3\">" << m_vertexBlock.str() << "</vertices>\n";
+		m_vertexBlock.str("");
+		m_blockVertices = 0;
+	}
+	if (m_blockEdges > 0) {
+		m_out << "<edges>" << m_edgeBlock.str() << "</edges>\n";
+		m_edgeBlock.str("");
+		m_blockEdges = 0;
+	}
+}
+
+void UGXStreamWriter::add_to_ranges(Ranges& ranges, size_t i) {
+	if (!ranges.empty() && ranges.back().second + 1 == i) {
+		ranges.back().second = i;
+	} else {
+		ranges.push_back(make_pair(i, i));
+	}
+}
+
+void UGXStreamWriter::write_ranges(const Ranges& ranges) {
+	for (size_t r = 0; r < ranges.size(); r++) {
+		for (size_t i = ranges[r].first; i <= ranges[r].second; i++) {
+			m_out << i << ' ';
+		}
+	}
+}
+
+bool UGXStreamWriter::close() {
+	if (!m_out.is_open()) return true;
+	flush();
+
+	m_out << "<vertex_attachment name=\"diameter\" type=\"double\" passOn=\"0\" global=\"1\">";
+	for (size_t i = 0; i < m_diameters.size(); i++) {
+		m_out << m_diameters[i] << ' ';
+	}
+	m_out << "</vertex_attachment>\n";
+
+	/// subsets without elements are omitted, as by EraseEmptySubsets
+	m_out << "<subset_handler name=\"defSH\">\n";
+	for (size_t si = 0; si < m_subsets.size(); si++) {
+		const Subset& s = m_subsets[si];
+		if (s.vertices.empty() && s.edges.empty()) continue;
+		m_out << "<subset name=\"" << XMLEscape(s.name) << "\" color=\"" << s.color[0] << ' ' << s.color[1] << ' '
+			  << s.color[2] << ' ' << s.color[3] << "\" state=\"0\">\n";
+		if (!s.vertices.empty()) {
+			m_out << "<vertices>";
+			write_ranges(s.vertices);
+			m_out << "</vertices>\n";
+		}
+		if (!s.edges.empty()) {
+			m_out << "<edges>";
+			write_ranges(s.edges);
+			m_out << "</edges>\n";
+		}
+		m_out << "</subset>\n";
+	}
+	m_out << "</subset_handler>\n";
+	m_out << "</grid>\n";
+
+	bool written = m_out.close();
+	m_diameters.clear();
+	m_vertexHash.clear();
+	m_edges.clear();
+	m_subsets.clear();
+	return written;
+}
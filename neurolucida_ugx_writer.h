@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_ugx_writer.h
+ * \brief writes UGX files without building a grid
+ *
+ * Vertices and edges are written in blocks as soon as they are created, only
+ * their diameters, a hash of the vertex positions, the written edges and the
+ * subsets of the elements (as ranges of indices) are kept until the file is
+ * closed. Memory is thus linear in the number of elements, but much smaller
+ * than for a grid. The
+ * format is the one written by SaveGridToFile: a UGX file may contain several
+ * vertex and edge blocks, the indices of which continue over all blocks.
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_UGX_WRITER__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_UGX_WRITER__
+
+#include <functional>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include <common/math/ugmath.h>
+
+#include "neurolucida_compression.h"
+#include "neurolucida_vertex_hash.h"
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief escapes a string for an XML attribute value
+		 */
+		std::string XMLEscape(const std::string& str);
+
+		class UGXStreamWriter {
+		public:
+			/// number of vertices respectively edges buffered before a block is written
+			static const size_t BLOCK_SIZE = 65536;
+
+			/*!
+			 * \param[in] threshold vertices closer than the threshold are merged
+			 */
+			explicit UGXStreamWriter(number threshold);
+
+			/*!
+			 * \brief opens the output file and writes the header
+			 * \param[in] compression one of Compression, the file is compressed while written
+			 * \return false if the file could not be opened
+			 */
+			bool open(const std::string& filename, int compression = COMPRESSION_NONE);
+
+			/*!
+			 * \brief writes the remaining elements, the diameters and the subsets
+			 * \return false if the file could not be written completely
+			 */
+			bool close();
+
+			inline bool is_open() const {
+				return m_out.is_open();
+			}
+
+			/*!
+			 * \brief returns the vertex at the position
+			 * A new vertex is written unless there is a vertex closer than the threshold.
+			 * \param[in] diameter diameter of a new vertex
+			 * \param[in] si subset of a new vertex, -1 for none
+			 * \param[out] created true if a new vertex was written
+			 * \return index of the vertex
+			 */
+			size_t vertex(const ug::vector3& pos, number diameter, int si, bool& created);
+
+			/*!
+			 * \brief writes a new vertex without looking for a close one
+			 * For vertices known to be distinct, e.g. those of a grid: the index of
+			 * the vertex is the number of vertices written before. The vertex is not
+			 * merged with vertices passed to vertex later on.
+			 * \param[in] si subset of the vertex, -1 for none
+			 * \return index of the vertex
+			 */
+			size_t add_vertex(const ug::vector3& pos, number diameter, int si);
+
+			/*!
+			 * \brief finds a vertex closer than the threshold to the position
+			 */
+			inline bool find_vertex(const ug::vector3& pos, size_t& vertex) const {
+				return m_vertexHash.find(pos, vertex);
+			}
+
+			/*!
+			 * \brief writes an edge unless it already exists or would be degenerated
+			 */
+			void edge(size_t from, size_t to, int si);
+
+			/*!
+			 * \brief writes an edge without checking if it already exists
+			 * For edges known to be distinct, e.g. those of a grid, no edge set is kept.
+			 */
+			void add_edge(size_t from, size_t to, int si);
+
+			/*!
+			 * \brief sets name and color of a subset
+			 */
+			void set_subset_info(int si, const std::string& name, const ug::MathVector<4>& color);
+
+			inline number diameter(size_t vertex) const {
+				return m_diameters[vertex];
+			}
+
+			inline size_t num_vertices() const {
+				return m_diameters.size();
+			}
+
+			inline size_t num_edges() const {
+				return m_numEdges;
+			}
+
+		private:
+			/// closed ranges of element indices
+			typedef std::vector<std::pair<size_t, size_t> > Ranges;
+
+			/// vertex indices of an edge, the smaller one first
+			typedef std::pair<size_t, size_t> EdgeKey;
+
+			struct EdgeKeyHash {
+				size_t operator()(const EdgeKey& edge) const {
+					return std::hash<size_t>()(edge.first * 0x9e3779b97f4a7c15ULL ^ edge.second);
+				}
+			};
+
+			struct Subset {
+				std::string name;
+				ug::MathVector<4> color;
+				Ranges vertices;
+				Ranges edges;
+			};
+
+			Subset& subset(int si);
+			void flush();
+			static void add_to_ranges(Ranges& ranges, size_t i);
+			void write_ranges(const Ranges& ranges);
+
+			/// not copyable
+			UGXStreamWriter(const UGXStreamWriter&);
+			UGXStreamWriter& operator=(const UGXStreamWriter&);
+
+		private:
+			OutputFile m_out;
+			std::ostringstream m_vertexBlock;
+			std::ostringstream m_edgeBlock;
+			size_t m_blockVertices;
+			size_t m_blockEdges;
+			size_t m_numEdges;
+			PositionHash<size_t> m_vertexHash;
+			std::unordered_set<EdgeKey, EdgeKeyHash> m_edges;
+			std::vector<number> m_diameters;
+			std::vector<Subset> m_subsets;
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_UGX_WRITER__
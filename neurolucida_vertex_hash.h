@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+/*!
+ * \file neurolucida_vertex_hash.h
+ * \brief uniform hash grid to find already created vertices by position
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#ifndef __H__UG__NEUROLUCIDA__NEUROLUCIDA_VERTEX_HASH__
+#define __H__UG__NEUROLUCIDA__NEUROLUCIDA_VERTEX_HASH__
+
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+
+#include <common/math/ugmath.h>
+#include "lib_grid/lib_grid.h"
+
+namespace ug {
+	namespace neurolucida {
+		/*!
+		 * \brief maps positions to values, e.g. vertices
+		 * Positions are quantized into cubic cells with an edge length of the
+		 * threshold, hence a position closer than the threshold to a given position
+		 * is always located in the cell of that position or in a neighboring cell.
+		 */
+		template <typename TValue>
+		class PositionHash {
+		public:
+			explicit PositionHash(number threshold) : m_threshold(threshold) {
+			}
+
+			/*!
+			 * \brief finds the value of a position closer than the threshold to the position
+			 * If several positions are close enough, the value of the closest one is returned.
+			 * \return false if there is no such position
+			 */
+			bool find(const ug::vector3& pos, TValue& value) const {
+				const CellKey center = key(pos);
+				bool found = false;
+				number closestDistSq = m_threshold * m_threshold;
+				for (long long i = -1; i <= 1; i++) {
+					for (long long j = -1; j <= 1; j++) {
+						for (long long k = -1; k <= 1; k++) {
+							CellKey cell = {center.x + i, center.y + j, center.z + k};
+							std::pair<ConstIterator, ConstIterator> range = m_cells.equal_range(cell);
+							for (ConstIterator it = range.first; it != range.second; ++it) {
+								number distSq = VecDistanceSq(it->second.first, pos);
+								if (distSq < closestDistSq) {
+									closestDistSq = distSq;
+									value = it->second.second;
+									found = true;
+								}
+							}
+						}
+					}
+				}
+				return found;
+			}
+
+			/*!
+			 * \brief registers a value at the given position
+			 */
+			void insert(const TValue& value, const ug::vector3& pos) {
+				m_cells.insert(std::make_pair(key(pos), std::make_pair(pos, value)));
+			}
+
+			void clear() {
+				m_cells.clear();
+			}
+
+			inline size_t size() const {
+				return m_cells.size();
+			}
+
+			inline void set_threshold(number threshold) {
+				clear();
+				m_threshold = threshold;
+			}
+
+			inline number get_threshold() const {
+				return m_threshold;
+			}
+
+		private:
+			struct CellKey {
+				long long x;
+				long long y;
+				long long z;
+
+				bool operator==(const CellKey& other) const {
+					return x == other.x && y == other.y && z == other.z;
+				}
+			};
+
+			struct CellKeyHash {
+				size_t operator()(const CellKey& cell) const {
+					/// large primes as in Teschner et al., Optimized Spatial Hashing for Collision Detection
+					return static_cast<size_t>(cell.x * 73856093LL) ^ static_cast<size_t>(cell.y * 19349663LL) ^ static_cast<size_t>(cell.z * 83492791LL);
+				}
+			};
+
+			typedef std::unordered_multimap<CellKey, std::pair<ug::vector3, TValue>, CellKeyHash> CellMap;
+			typedef typename CellMap::const_iterator ConstIterator;
+
+			inline CellKey key(const ug::vector3& pos) const {
+				CellKey cell = {static_cast<long long>(std::floor(pos[0] / m_threshold)),
+								static_cast<long long>(std::floor(pos[1] / m_threshold)),
+								static_cast<long long>(std::floor(pos[2] / m_threshold))};
+				return cell;
+			}
+
+		private:
+			number m_threshold;
+			CellMap m_cells;
+		};
+
+		/*!
+		 * \brief maps positions to grid vertices
+		 */
+		class VertexHash : public PositionHash<ug::Vertex*> {
+		public:
+			explicit VertexHash(number threshold) : PositionHash<ug::Vertex*>(threshold) {
+			}
+
+			using PositionHash<ug::Vertex*>::find;
+
+			/*!
+			 * \brief returns a vertex closer than the threshold to the position or NULL
+			 */
+			ug::Vertex* find(const ug::vector3& pos) const {
+				ug::Vertex* vtx = NULL;
+				find(pos, vtx);
+				return vtx;
+			}
+		};
+	}
+}
+
+#endif /// __H__UG__NEUROLUCIDA__NEUROLUCIDA_VERTEX_HASH__
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2010-2015:  G-CSC, Goethe University Frankfurt
+ * Author: Andreas Vogel
+ *
+ * This file is part of UG4.
+ *
+ * UG4 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ *
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (2) The following notice must be displayed at a prominent place in the
+ * terminal output of covered works: "Based on UG4 (www.ug4.org/license)".
+ *
+ * (3) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S., Vogel, A., Heppner, I., Rupp, M., and Wittum, G. A massively
+ *   parallel geometric multigrid solver on hierarchically distributed grids.
+ *   Computing and visualization in science 16, 4 (2013), 151-164"
+ * "Vogel, A., Reiter, S., Rupp, M., Nägel, A., and Wittum, G. UG4 -- a novel
+ *   flexible software system for simulating pde based models on high performance
+ *   computers. Computing and visualization in science 16, 4 (2013), 165-179"
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+/*!
+ * \file neurolucida_test.cpp
+ * \brief regression tests of the conversion, returns the number of failed tests
+ *
+ * Usage: neurolucida_test [directory for the temporary files]
+ *
+ *  Created on: Oct 17, 2016
+ *      Author: Stephan Grein
+ */
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ug.h"
+#include "lib_grid/global_attachments.h"
+#include "../neurolucida.h"
+
+using namespace std;
+using namespace ug;
+using namespace ug::neurolucida;
+
+namespace {
+	/// vertices and edges of a written .ugx file
+	struct UGXGeometry {
+		vector<vector3> vertices;
+		vector<pair<size_t, size_t> > edges;
+	};
+
+	/*!
+	 * \brief reads the vertices and edges of a .ugx file
+	 * Blocks are concatenated, the subset handler is ignored.
+	 */
+	UGXGeometry read_ugx(const string& fileName) {
+		ifstream in(fileName.c_str());
+		stringstream content;
+		content << in.rdbuf();
+		const string text = content.str().substr(0, content.str().find("<subset_handler"));
+
+		UGXGeometry geometry;
+		const string vertexTag = "<vertices coords=\"3\">";
+		for (size_t pos = text.find(vertexTag); pos != string::npos; pos = text.find(vertexTag, pos)) {
+			pos += vertexTag.size();
+			istringstream block(text.substr(pos, text.find('<', pos) - pos));
+			vector3 v;
+			while (block >> v[0] >> v[1] >> v[2]) geometry.vertices.push_back(v);
+		}
+		const string edgeTag = "<edges>";
+		for (size_t pos = text.find(edgeTag); pos != string::npos; pos = text.find(edgeTag, pos)) {
+			pos += edgeTag.size();
+			istringstream block(text.substr(pos, text.find('<', pos) - pos));
+			size_t from, to;
+			while (block >> from >> to) geometry.edges.push_back(make_pair(from, to));
+		}
+		return geometry;
+	}
+
+	/// index of the vertex at the position or the number of vertices if there is none
+	size_t find_vertex(const UGXGeometry& geometry, number x, number y, number z) {
+		for (size_t i = 0; i < geometry.vertices.size(); i++) {
+			const vector3& v = geometry.vertices[i];
+			if (fabs(v[0] - x) < 1e-9 && fabs(v[1] - y) < 1e-9 && fabs(v[2] - z) < 1e-9) return i;
+		}
+		return geometry.vertices.size();
+	}
+
+	bool has_edge(const UGXGeometry& geometry, size_t a, size_t b) {
+		for (size_t i = 0; i < geometry.edges.size(); i++) {
+			const pair<size_t, size_t>& e = geometry.edges[i];
+			if ((e.first == a && e.second == b) || (e.first == b && e.second == a)) return true;
+		}
+		return false;
+	}
+
+	size_t numFailures = 0;
+
+	void check(bool condition, const string& test, const string& what) {
+		if (condition) return;
+		cerr << "FAILED " << test << ": " << what << endl;
+		numFailures++;
+	}
+
+	/*!
+	 * \brief a tree whose root lies exactly on a soma edge splits that edge at the root
+	 * Looking up the attachment vertex among all vertices returned the root itself,
+	 * the resulting self-loop was dropped and the tree was never connected.
+	 */
+	void test_root_on_soma_edge(const string& directory, bool streamingOutput) {
+		const string test = string("root on soma edge (") + (streamingOutput ? "streaming" : "grid") + ")";
+		const string fileName = directory + "/root_on_soma_edge" + (streamingOutput ? "_streaming" : "_grid") + ".xml";
+		{
+			ofstream out(fileName.c_str());
+			out << "<?xml version=\"1.0\"?>\n<mbf>\n"
+				<< "<contour name=\"Cell Body\" closed=\"true\">"
+				<< "<point x=\"0\" y=\"0\" z=\"0\" d=\"1\"/><point x=\"100\" y=\"0\" z=\"0\" d=\"1\"/>"
+				<< "<point x=\"100\" y=\"100\" z=\"0\" d=\"1\"/><point x=\"0\" y=\"100\" z=\"0\" d=\"1\"/>"
+				<< "<point x=\"0\" y=\"0\" z=\"0\" d=\"1\"/></contour>\n"
+				<< "<tree type=\"Dendrite\"><point x=\"50\" y=\"0\" z=\"0\" d=\"1\"/><point x=\"50\" y=\"-50\" z=\"0\" d=\"1\"/></tree>\n"
+				<< "</mbf>\n";
+		}
+
+		Neurolucida converter;
+		converter.set_log_level(Neurolucida::LOG_SILENT);
+		converter.set_scaling(1);
+		converter.set_soma_attachment(Neurolucida::SOMA_ATTACH_EDGE);
+		converter.set_streaming_output(streamingOutput);
+		converter.convert(fileName);
+
+		const UGXGeometry geometry = read_ugx(fileName.substr(0, fileName.size() - 4) + ".ugx");
+		const size_t none = geometry.vertices.size();
+		const size_t root = find_vertex(geometry, 50, 0, 0);
+		const size_t tip = find_vertex(geometry, 50, -50, 0);
+		const size_t left = find_vertex(geometry, 0, 0, 0);
+		const size_t right = find_vertex(geometry, 100, 0, 0);
+		check(root != none && tip != none && left != none && right != none, test, "vertices missing");
+		if (root == none || tip == none || left == none || right == none) return;
+
+		check(has_edge(geometry, root, tip), test, "tree edge missing");
+		check(has_edge(geometry, left, root) && has_edge(geometry, root, right), test, "soma edge not split at the root");
+		check(!has_edge(geometry, left, right), test, "split soma edge still present");
+		check(geometry.vertices.size() == 6, test, "root vertex duplicated");
+	}
+
+	/*!
+	 * \brief a .gz file missing its trailer is rejected instead of read as complete
+	 * The document itself is decompressed completely, thus only the decompression notices the truncation.
+	 */
+	void test_truncated_gzip(const string& directory, bool streaming) {
+		const string test = string("truncated gzip (") + (streaming ? "streaming" : "DOM") + ")";
+		if (!CompressionAvailable(COMPRESSION_GZIP)) return;
+
+		const string fileName = directory + "/truncated" + (streaming ? "_streaming" : "_dom") + ".xml.gz";
+		{
+			OutputFile out;
+			check(out.open(fileName, COMPRESSION_GZIP), test, "could not write the file");
+			out << "<?xml version=\"1.0\"?>\n<mbf>\n<tree type=\"Dendrite\">";
+			for (size_t i = 0; i < 1000; i++) {
+				out << "<point x=\"" << i << "\" y=\"0\" z=\"0\" d=\"1\"/>";
+			}
+			out << "</tree>\n</mbf>\n";
+			check(out.close(), test, "could not write the file");
+		}
+
+		/// the gzip trailer holds the checksum and size in 8 bytes
+		string content;
+		{
+			ifstream in(fileName.c_str(), ios::binary);
+			stringstream ss;
+			ss << in.rdbuf();
+			content = ss.str();
+		}
+		check(content.size() > 8, test, "file too small");
+		if (content.size() <= 8) return;
+		{
+			ofstream out(fileName.c_str(), ios::binary);
+			out.write(content.data(), content.size() - 8);
+		}
+
+		Neurolucida converter;
+		converter.set_log_level(Neurolucida::LOG_SILENT);
+		converter.set_streaming(streaming);
+		bool thrown = false;
+		try {
+			converter.convert(fileName, false, false);
+		} catch (const UGError&) {
+			thrown = true;
+		}
+		check(thrown, test, "truncated file was accepted");
+	}
+}
+
+int main(int argc, char** argv) {
+	const string directory = argc > 1 ? argv[1] : ".";
+
+	UGInit(&argc, &argv);
+	if (!GlobalAttachments::is_declared("diameter")) {
+		GlobalAttachments::declare_attachment<ANumber>("diameter");
+	}
+
+	test_root_on_soma_edge(directory, false);
+	test_root_on_soma_edge(directory, true);
+	test_truncated_gzip(directory, false);
+	test_truncated_gzip(directory, true);
+
+	if (numFailures == 0) cout << "All tests passed." << endl;
+	UGFinalize();
+	return static_cast<int>(numFailures);
+}